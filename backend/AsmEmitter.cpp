@@ -0,0 +1,9 @@
+#include "../include/backend/AsmEmitter.hpp"
+#include <cstdio>
+
+bool AsmEmitter::WriteTo(const std::string& path)const{
+    FILE* file=fopen(path.c_str(),"wb");
+    if(file==nullptr)return false;
+    bool ok=fwrite(buffer.data(),1,buffer.size(),file)==buffer.size();
+    return fclose(file)==0&&ok;
+}
@@ -0,0 +1,143 @@
+#include "../include/backend/BlockPlacement.hpp"
+#include "../include/backend/BranchFolding.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+bool BlockPlacement::run(RISCVFunction* mfunc){
+    func=mfunc;
+    order.clear();
+    edges.clear();
+    int index=0;
+    for(auto block:*func)
+        order[block]=index++;
+    BuildEdges();
+    auto layout=BuildLayout();
+    std::vector<RISCVBasicBlock*> old;
+    for(auto block:*func)
+        old.push_back(block);
+    bool modified=layout!=old;
+    if(modified){
+        for(auto block:layout)
+            block->EraseFromParent();
+        for(auto block:layout)
+            func->push_back(block);
+    }
+    modified|=FixBranches(layout);
+    return modified;
+}
+
+RISCVMIR::RISCVISA BlockPlacement::InvertBranch(RISCVMIR::RISCVISA opcode){
+    switch(opcode){
+        case RISCVMIR::_beq:return RISCVMIR::_bne;
+        case RISCVMIR::_bne:return RISCVMIR::_beq;
+        case RISCVMIR::_blt:return RISCVMIR::_bge;
+        case RISCVMIR::_bge:return RISCVMIR::_blt;
+        case RISCVMIR::_ble:return RISCVMIR::_bgt;
+        case RISCVMIR::_bgt:return RISCVMIR::_ble;
+        case RISCVMIR::_bltu:return RISCVMIR::_bgeu;
+        case RISCVMIR::_bgeu:return RISCVMIR::_bltu;
+        default:assert(0&&"Not a conditional branch");
+    }
+    return opcode;
+}
+
+void BlockPlacement::BuildEdges(){
+    auto isReturn=[](RISCVBasicBlock* block){
+        return block->Size()!=0&&(block->back()->GetOpcode()==RISCVMIR::ret||block->back()->GetOpcode()==RISCVMIR::tail);
+    };
+    for(auto block:*func){
+        auto branches=BranchFolding::GetBranches(block);
+        if(branches.empty())
+            continue;
+        double freq=std::pow(10.0,std::min(block->LoopDepth,6));
+        std::vector<RISCVBasicBlock*> targets;
+        for(auto minst:branches)
+            targets.push_back(dynamic_cast<RISCVBasicBlock*>(minst->GetOperand(minst->GetOperandSize()-1)));
+        std::vector<double> prob(targets.size(),1.0/targets.size());
+        if(targets.size()==2){
+            auto taken=targets[0],other=targets[1];
+            double p=0.5;
+            if(taken->LoopDepth!=other->LoopDepth)
+                p=taken->LoopDepth>other->LoopDepth?0.875:0.125;
+            else if(isReturn(taken)!=isReturn(other))
+                p=isReturn(taken)?0.25:0.75;
+            else if((order[taken]<=order[block])!=(order[other]<=order[block]))
+                p=order[taken]<=order[block]?0.875:0.125;
+            prob={p,1-p};
+        }
+        for(int i=0;i<targets.size();i++){
+            if(targets[i]==nullptr||targets[i]==block)
+                continue;
+            edges.push_back({block,targets[i],freq*prob[i],order[targets[i]]<=order[block]});
+        }
+    }
+}
+
+/// @brief 权重从大到小, 一条边的起点是某条链的尾, 终点是另一条链的头时把两条链接起来
+std::vector<RISCVBasicBlock*> BlockPlacement::BuildLayout(){
+    std::stable_sort(edges.begin(),edges.end(),[](const Edge& a,const Edge& b){
+        if(a.weight!=b.weight)
+            return a.weight>b.weight;
+        // 同样热时先接回边, 循环体落到 header 上
+        return a.backedge&&!b.backedge;
+    });
+    std::map<RISCVBasicBlock*,std::vector<RISCVBasicBlock*>*> chainof;
+    std::vector<std::unique_ptr<std::vector<RISCVBasicBlock*>>> chains;
+    for(auto block:*func){
+        chains.emplace_back(new std::vector<RISCVBasicBlock*>{block});
+        chainof[block]=chains.back().get();
+    }
+    auto entry=func->GetEntry();
+    for(auto& edge:edges){
+        auto from=chainof[edge.from],to=chainof[edge.to];
+        if(from==to||from->back()!=edge.from||to->front()!=edge.to||edge.to==entry)
+            continue;
+        for(auto block:*to){
+            from->push_back(block);
+            chainof[block]=from;
+        }
+        to->clear();
+    }
+    // entry 所在的链放最前, 其余按链头原来的顺序
+    std::vector<std::vector<RISCVBasicBlock*>*> sorted;
+    for(auto& chain:chains)
+        if(!chain->empty()&&chain.get()!=chainof[entry])
+            sorted.push_back(chain.get());
+    std::sort(sorted.begin(),sorted.end(),[&](std::vector<RISCVBasicBlock*>* a,std::vector<RISCVBasicBlock*>* b){
+        return order[a->front()]<order[b->front()];
+    });
+    sorted.insert(sorted.begin(),chainof[entry]);
+    std::vector<RISCVBasicBlock*> layout;
+    for(auto chain:sorted)
+        layout.insert(layout.end(),chain->begin(),chain->end());
+    return layout;
+}
+
+/// @brief 按最后的排布去掉到下一块的 j, 或者反转条件跳转
+bool BlockPlacement::FixBranches(std::vector<RISCVBasicBlock*>& layout){
+    bool modified=false;
+    for(int i=0;i+1<layout.size();i++){
+        auto block=layout[i],next=layout[i+1];
+        auto branches=BranchFolding::GetBranches(block);
+        if(branches.empty()||branches.back()->GetOpcode()!=RISCVMIR::_j)
+            continue;
+        auto jump=branches.back();
+        if(jump->GetOperand(0)==next){
+            delete jump;
+            modified=true;
+            continue;
+        }
+        if(branches.size()<2)
+            continue;
+        auto cond=branches[branches.size()-2];
+        int target=cond->GetOperandSize()-1;
+        if(cond->GetOperand(target)!=next)
+            continue;
+        cond->SetMopcode(InvertBranch(cond->GetOpcode()));
+        cond->SetOperand(target,jump->GetOperand(0));
+        delete jump;
+        modified=true;
+    }
+    return modified;
+}
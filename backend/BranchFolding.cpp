@@ -0,0 +1,112 @@
+#include "../include/backend/BranchFolding.hpp"
+
+bool BranchFolding::run(RISCVFunction* mfunc){
+    func=mfunc;
+    bool modified=false,changed;
+    do{
+        changed=FoldCondBranches();
+        changed|=ThreadJumps();
+        changed|=MergeBlocks();
+        changed|=RemoveDeadBlocks();
+        modified|=changed;
+    }while(changed);
+    return modified;
+}
+
+bool BranchFolding::isBranch(RISCVMIR* minst){
+    auto opcode=minst->GetOpcode();
+    return opcode>RISCVMIR::BeginBranch&&opcode<RISCVMIR::EndBranch;
+}
+
+/// @brief 块末尾连续的跳转指令
+std::vector<RISCVMIR*> BranchFolding::GetBranches(RISCVBasicBlock* block){
+    std::vector<RISCVMIR*> branches;
+    for(auto it=block->rbegin();it!=block->rend();--it){
+        if(!isBranch(*it))break;
+        branches.insert(branches.begin(),*it);
+    }
+    return branches;
+}
+
+void BranchFolding::CountRefs(){
+    refs.clear();
+    for(auto block:*func)
+        for(auto minst:GetBranches(block))
+            for(int i=0;i<minst->GetOperandSize();i++)
+                if(auto target=dynamic_cast<RISCVBasicBlock*>(minst->GetOperand(i)))
+                    refs[target]++;
+}
+
+/// @brief b<cc> .., T; j T 里的条件跳转是多余的
+bool BranchFolding::FoldCondBranches(){
+    bool modified=false;
+    for(auto block:*func){
+        auto branches=GetBranches(block);
+        if(branches.size()<2||branches.back()->GetOpcode()!=RISCVMIR::_j)
+            continue;
+        auto target=branches.back()->GetOperand(0);
+        auto cond=branches[branches.size()-2];
+        if(cond->GetOperand(cond->GetOperandSize()-1)!=target)
+            continue;
+        delete cond;
+        modified=true;
+    }
+    return modified;
+}
+
+/// @brief 只有一条 j T 的块, 所有跳到它的地方直接跳到 T
+bool BranchFolding::ThreadJumps(){
+    bool modified=false;
+    for(auto block:*func){
+        if(block==func->GetEntry()||block->Size()!=1||block->front()->GetOpcode()!=RISCVMIR::_j)
+            continue;
+        auto target=block->front()->GetOperand(0);
+        if(target==block)
+            continue;
+        for(auto pred:*func)
+            for(auto minst:GetBranches(pred))
+                for(int i=0;i<minst->GetOperandSize();i++)
+                    if(minst->GetOperand(i)==block){
+                        minst->SetOperand(i,target);
+                        modified=true;
+                    }
+    }
+    return modified;
+}
+
+/// @brief 以 j S 结尾的块, S 只有它一个前驱时把 S 的指令搬过来
+bool BranchFolding::MergeBlocks(){
+    bool modified=false;
+    CountRefs();
+    for(auto block:*func){
+        // 前面还有条件跳转时不能接, 不然跳转指令就落到块中间了
+        while(GetBranches(block).size()==1&&block->back()->GetOpcode()==RISCVMIR::_j){
+            auto jump=block->back();
+            auto succ=dynamic_cast<RISCVBasicBlock*>(jump->GetOperand(0));
+            if(succ==nullptr||succ==block||succ==func->GetEntry()||refs[succ]!=1)
+                break;
+            delete jump;
+            while(succ->Size()!=0){
+                auto minst=succ->front();
+                minst->EraseFromParent();
+                block->push_back(minst);
+            }
+            // succ 已经空了, 留给 RemoveDeadBlocks 删
+            refs[succ]=0;
+            modified=true;
+        }
+    }
+    return modified;
+}
+
+/// @note 块可能还挂在 ctx 的映射里, 只摘下来不释放
+bool BranchFolding::RemoveDeadBlocks(){
+    CountRefs();
+    std::vector<RISCVBasicBlock*> dead;
+    for(auto block:*func)
+        if(block!=func->GetEntry()&&refs[block]==0)
+            dead.push_back(block);
+    for(auto block:dead)
+        block->EraseFromParent();
+    return !dead.empty();
+}
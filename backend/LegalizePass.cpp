@@ -57,7 +57,7 @@ void Legalize::LegalizePass(mylist<RISCVBasicBlock, RISCVMIR>::iterator it) {
     using ISA = RISCVMIR::RISCVISA;
     RISCVMIR* inst = *it;
     ISA opcode = inst->GetOpcode();
-    if(opcode==ISA::call||opcode==ISA::ret) {return;}
+    if(opcode==ISA::call||opcode==ISA::ret||opcode==ISA::tail) {return;}
     for(int i=0; i<inst->GetOperandSize(); i++){
         RISCVMOperand* oprand = inst->GetOperand(i);
         // StackReg and Frameobj out memory inst
@@ -106,7 +106,7 @@ void Legalize::LegalizePass_before(mylist<RISCVBasicBlock, RISCVMIR>::iterator i
     using ISA = RISCVMIR::RISCVISA;
     RISCVMIR* inst = *it;
     ISA opcode = inst->GetOpcode();
-    if(opcode==ISA::call||opcode==ISA::ret) {return;}
+    if(opcode==ISA::call||opcode==ISA::ret||opcode==ISA::tail) {return;}
     for(int i=0; i<inst->GetOperandSize(); i++){
         RISCVMOperand* oprand = inst->GetOperand(i);
         // StackReg and Frameobj out memory inst
@@ -123,7 +123,7 @@ void Legalize::LegalizePass_after(mylist<RISCVBasicBlock, RISCVMIR>::iterator it
     using ISA = RISCVMIR::RISCVISA;
     RISCVMIR* inst = *it;
     ISA opcode = inst->GetOpcode();
-    if(opcode==ISA::call||opcode==ISA::ret) {return;}
+    if(opcode==ISA::call||opcode==ISA::ret||opcode==ISA::tail) {return;}
     for(int i=0; i<inst->GetOperandSize(); i++){
         RISCVMOperand* oprand = inst->GetOperand(i);
         // StackReg and Frameobj out memory inst
@@ -263,94 +263,21 @@ void Legalize::constintLegalize(int i, mylist<RISCVBasicBlock, RISCVMIR>::iterat
         return;
     }
     else {
-        int mod = inttemp % 4096;
-        if(mod==0) {
-            if(inst->GetOpcode() == RISCVMIR::RISCVISA::li) {
-                return;
-            }
-            else if(inst->GetOpcode() == RISCVMIR::RISCVISA::_addi ||\
-                    inst->GetOpcode() == RISCVMIR::RISCVISA::_addiw) {
-                RISCVMIR* li = new RISCVMIR(RISCVMIR::RISCVISA::li);
-                // VirRegister* vreg = new VirRegister(RISCVType::riscv_i32);
-                li->SetDef(t0);
-                li->AddOperand(constdata);
-                it.insert_before(li);
-                for(int i=0; i<inst->GetOperandSize(); i++) {
-                    if(Imm* imm = dynamic_cast<Imm*>(inst->GetOperand(i))) {
-                        if(imm->Getdata()==constdata->Getdata()) {
-                            inst->SetOperand(i,t0);
-                            break;
-                        }
-                    } 
-                }
-                MOpcodeLegalize(inst);
-            }
-            else {
-                inst->SetMopcode(RISCVMIR::RISCVISA::li);
-            }
+        // li 是伪指令, 汇编器会拆成 lui+addiw; 自己按 4096 拆的话 0x7ffff800 以上的数高位进位会溢出
+        if(inst->GetOpcode() == RISCVMIR::RISCVISA::li) {
             return;
-
-        } else if((mod>0&&mod<2048)||(mod>=-2048&&mod<0)) {
-            // VirRegister* vreg = ctx.createVReg(RISCVType::riscv_i32);
-            Imm* const_imm = new Imm(ConstIRInt::GetNewConstant(inttemp-mod));
-            RISCVMIR* li = new RISCVMIR(RISCVMIR::RISCVISA::li);
-            li->SetDef(t0);
-            li->AddOperand(const_imm);
-            it.insert_before(li);
-            Imm* mod_imm = new Imm(ConstIRInt::GetNewConstant(mod));
-            RISCVMIR* addi = new RISCVMIR(RISCVMIR::RISCVISA::_addi);
-            addi->SetDef(t0);
-            addi->AddOperand(t0);
-            addi->AddOperand(mod_imm);
-            it.insert_before(addi);
-            MOpcodeLegalize(inst);
-            for(int i=0; i<inst->GetOperandSize(); i++) {
-                while(inst->GetOperand(i)==constdata) {
-                    inst->SetOperand(i,t0);
-                    return;
-                }
-            }
-        } else if (mod >=2048 && mod <4096) {
-            // VirRegister* vreg = ctx.createVReg(RISCVType::riscv_i32);
-            Imm* const_imm = new Imm(ConstIRInt::GetNewConstant(inttemp-mod+4096));
-            RISCVMIR* li = new RISCVMIR(RISCVMIR::RISCVISA::li);
-            li->SetDef(t0);
-            li->AddOperand(const_imm);
-            it.insert_before(li);
-            Imm* mod_imm = new Imm(ConstIRInt::GetNewConstant(mod-4096));
-            RISCVMIR* addi = new RISCVMIR(RISCVMIR::RISCVISA::_addi);
-            addi->SetDef(t0);
-            addi->AddOperand(t0);
-            addi->AddOperand(mod_imm);
-            it.insert_before(addi);
-            MOpcodeLegalize(inst);
-            for(int i=0; i<inst->GetOperandSize(); i++) {
-                while(inst->GetOperand(i)==constdata) {
-                    inst->SetOperand(i,t0);
-                    return;
-                }
-            }
-        } else if (mod>=-4095&&mod<-2048) {
-            // VirRegister* vreg = ctx.createVReg(RISCVType::riscv_i32);
-            Imm* const_imm = new Imm(ConstIRInt::GetNewConstant(inttemp-mod-4096));
-            RISCVMIR* li = new RISCVMIR(RISCVMIR::RISCVISA::li);
-            li->SetDef(t0);
-            li->AddOperand(const_imm);
-            it.insert_before(li);
-            Imm* mod_imm = new Imm(ConstIRInt::GetNewConstant(mod+4096));
-            RISCVMIR* addi = new RISCVMIR(RISCVMIR::RISCVISA::_addi);
-            addi->SetDef(t0);
-            addi->AddOperand(t0);
-            addi->AddOperand(mod_imm);
-            it.insert_before(addi);
-            MOpcodeLegalize(inst);
-            for(int i=0; i<inst->GetOperandSize(); i++) {
-                while(inst->GetOperand(i)==constdata) {
-                    inst->SetOperand(i,t0);
-                    return;
-                }
+        }
+        RISCVMIR* li = new RISCVMIR(RISCVMIR::RISCVISA::li);
+        li->SetDef(t0);
+        li->AddOperand(constdata);
+        it.insert_before(li);
+        MOpcodeLegalize(inst);
+        for(int i=0; i<inst->GetOperandSize(); i++) {
+            if(inst->GetOperand(i)==constdata) {
+                inst->SetOperand(i,t0);
+                return;
             }
-        } else assert(0&&"error imm");
+        }
     }
 }
 
@@ -360,6 +287,9 @@ void Legalize::MOpcodeLegalize(RISCVMIR* inst) {
     if(opcode == ISA::_slli) inst->SetMopcode(ISA::_sll);
     else if(opcode == ISA::_srli) inst->SetMopcode(ISA::_srl);
     else if(opcode == ISA::_srai) inst->SetMopcode(ISA::_sra);
+    else if(opcode == ISA::_slliw) inst->SetMopcode(ISA::_sllw);
+    else if(opcode == ISA::_srliw) inst->SetMopcode(ISA::_srlw);
+    else if(opcode == ISA::_sraiw) inst->SetMopcode(ISA::_sraw);
     else if(opcode == ISA::_addi) inst->SetMopcode(ISA::_add);
     else if(opcode == ISA::_addiw) inst->SetMopcode(ISA::_addw);
     else if(opcode == ISA::_xori) inst->SetMopcode(ISA::_xor);
@@ -377,6 +307,9 @@ bool Legalize::isImminst(RISCVMIR::RISCVISA opcode)
     if(opcode == RISCVMIR::_slli ||
        opcode == RISCVMIR::_srli ||
        opcode == RISCVMIR::_srai ||
+       opcode == RISCVMIR::_slliw ||
+       opcode == RISCVMIR::_srliw ||
+       opcode == RISCVMIR::_sraiw ||
        opcode == RISCVMIR::_addi ||
        opcode == RISCVMIR::_addiw ||
        opcode == RISCVMIR::_xori ||
@@ -0,0 +1,355 @@
+#include "../include/backend/RISCVFrameContext.hpp"
+#include "../include/backend/RISCVMIR.hpp"
+#include "../include/backend/RISCVMOperand.hpp"
+#include "../include/backend/RISCVRegister.hpp"
+#include "../include/backend/RISCVType.hpp"
+#include "../include/backend/RegAlloc.hpp"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+using OpType = RISCVMIR::RISCVISA;
+
+static bool isCondBranch(OpType Opcode) {
+  return Opcode == OpType::_beq || Opcode == OpType::_bne ||
+         Opcode == OpType::_blt || Opcode == OpType::_bge ||
+         Opcode == OpType::_bltu || Opcode == OpType::_bgeu ||
+         Opcode == OpType::_bgt || Opcode == OpType::_ble;
+}
+
+bool LinearScan::LiveRange::Overlap(const LiveRange &other) const {
+  if (ranges.empty() || other.ranges.empty())
+    return false;
+  // 两边都按起点升序, 先跳过 other 里整个在 this 之前的段, 再归并着走
+  auto a = ranges.begin();
+  auto b = std::lower_bound(
+      other.ranges.begin(), other.ranges.end(), start(),
+      [](const Interval &range, int pos) { return range.end <= pos; });
+  while (a != ranges.end() && b != other.ranges.end()) {
+    if (a->start < b->end && b->start < a->end)
+      return true;
+    if (a->end <= b->end)
+      ++a;
+    else
+      ++b;
+  }
+  return false;
+}
+
+/// @brief 指令 i 的 use 在 2i, def 在 2i+1, 倒着扫每个块把活跃区间拼出来
+void LinearScan::BuildIntervals() {
+  lives.clear();
+  hints.clear();
+  remat.clear();
+  std::unordered_map<MOperand, int> defs;
+  auto range = [&](MOperand reg) -> LiveRange & {
+    int id = RegNum(reg);
+    if (id >= lives.size())
+      lives.resize(id + 1);
+    lives[id].reg = reg;
+    return lives[id];
+  };
+  auto addRange = [&](MOperand reg, int begin, int end) {
+    auto &ranges = range(reg).ranges;
+    if (!ranges.empty() && ranges.back().start <= end) {
+      ranges.back().start = std::min(ranges.back().start, begin);
+      ranges.back().end = std::max(ranges.back().end, end);
+    } else
+      ranges.push_back(Interval{begin, end});
+  };
+
+  std::vector<RISCVBasicBlock *> blocks;
+  std::vector<int> from;
+  int pos = 0;
+  for (RISCVBasicBlock *block : *m_func) {
+    blocks.push_back(block);
+    from.push_back(pos);
+    for (RISCVMIR *inst : *block)
+      pos += 2;
+  }
+  from.push_back(pos);
+
+  for (int b = blocks.size() - 1; b >= 0; b--) {
+    RISCVBasicBlock *block = blocks[b];
+    double freq = std::pow(10, std::min(block->LoopDepth, 6));
+    BitVector live = BlockLiveout[block];
+    live.visit([&](int id) { addRange(RegNum[id], from[b], from[b + 1]); });
+    // live 里的寄存器在当前块都有一段从块头开始的 range, 就是 ranges.back()
+    auto def = [&](MOperand reg) {
+      int id = RegNum(reg);
+      if (live.test(id))
+        range(reg).ranges.back().start = pos + 1;
+      else
+        addRange(reg, pos + 1, pos + 2);
+      live.reset(id);
+      range(reg).weight += freq;
+    };
+    auto use = [&](MOperand reg) {
+      int id = RegNum(reg);
+      if (!live.test(id))
+        addRange(reg, from[b], pos + 1);
+      live.set(id);
+      range(reg).weight += freq;
+    };
+    pos = from[b + 1];
+    for (auto it = block->rbegin(); it != block->rend(); --it) {
+      RISCVMIR *inst = *it;
+      pos -= 2;
+      OpType Opcode = inst->GetOpcode();
+      if (Opcode == OpType::_j)
+        continue;
+      else if (isCondBranch(Opcode)) {
+        for (int i = 0; i < 2; i++)
+          if (auto reg = inst->GetOperand(i)->ignoreLA())
+            use(reg);
+      } else if (Opcode == OpType::ret) {
+        if (inst->GetOperandSize() != 0) {
+          auto ty = inst->GetOperand(0)->GetType();
+          if (ty == RISCVType::riscv_i32)
+            use(PhyRegister::GetPhyReg(PhyRegister::PhyReg::a0));
+          else if (ty == RISCVType::riscv_float32)
+            use(PhyRegister::GetPhyReg(PhyRegister::PhyReg::fa0));
+        }
+      } else if (Opcode == OpType::call) {
+        // 调用会破坏所有 caller-saved, 相当于在这里 def 一遍
+        for (auto reg : reglist.GetReglistCaller())
+          def(reg);
+        for (int i = 0; i < inst->GetOperandSize(); i++)
+          if (inst->GetOperand(i))
+            if (auto reg = inst->GetOperand(i)->ignoreLA())
+              use(reg);
+      } else {
+        if (inst->GetDef())
+          if (auto reg = inst->GetDef()->ignoreLA()) {
+            def(reg);
+            if (++defs[reg] == 1 && isRematerializable(inst))
+              remat[reg] = inst;
+            else
+              remat.erase(reg);
+          }
+        for (int i = 0; i < inst->GetOperandSize(); i++) {
+          RISCVMOperand *op = inst->GetOperand(i);
+          if (op == nullptr)
+            continue;
+          // lui/addi 拆开的全局地址, 中间的 vreg 没法改写成栈槽
+          if (auto lareg = dynamic_cast<LARegister *>(op))
+            if (lareg->GetVreg())
+              unspillable.insert(lareg->GetVreg());
+          if (auto reg = op->ignoreLA())
+            use(reg);
+        }
+        if ((Opcode == OpType::mv || Opcode == OpType::_fmv_s) &&
+            inst->GetDef() && inst->GetDef()->ignoreLA() &&
+            inst->GetOperand(0)->ignoreLA()) {
+          MOperand dst = inst->GetDef()->ignoreLA();
+          MOperand src = inst->GetOperand(0)->ignoreLA();
+          hints[dst].push_back(src);
+          hints[src].push_back(dst);
+        }
+      }
+    }
+  }
+
+  for (auto &live : lives) {
+    std::reverse(live.ranges.begin(), live.ranges.end());
+    if (live.reg == nullptr || live.ranges.empty())
+      continue;
+    if (unspillable.count(live.reg)) {
+      live.weight = std::numeric_limits<double>::infinity();
+      continue;
+    }
+    // 同样的引用次数, 区间越长占着寄存器越久, 越应该溢出
+    int length = 0;
+    for (auto &range : live.ranges)
+      length += range.end - range.start;
+    live.weight /= std::max(length, 1);
+    if (remat.count(live.reg))
+      live.weight /= 2;
+  }
+}
+
+bool LinearScan::Allocate() {
+  bins.clear();
+  spilled.clear();
+  std::vector<LiveRange *> order;
+  for (auto &live : lives)
+    if (live.reg && !live.ranges.empty() &&
+        dynamic_cast<VirRegister *>(live.reg))
+      order.push_back(&live);
+  std::stable_sort(order.begin(), order.end(),
+                   [](LiveRange *a, LiveRange *b) {
+                     return a->start() < b->start();
+                   });
+  for (LiveRange *cur : order)
+    if (!Assign(*cur))
+      spilled.insert(dynamic_cast<VirRegister *>(cur->reg));
+  return spilled.empty();
+}
+
+bool LinearScan::Assign(LiveRange &cur) {
+  auto &regs = cur.reg->GetType() == RISCVType::riscv_float32
+                   ? reglist.GetReglistFloat()
+                   : reglist.GetReglistInt();
+  auto fixed = [&](PhyRegister *reg) -> LiveRange * {
+    auto it = RegNum.index.find(reg);
+    if (it == RegNum.index.end() || it->second >= lives.size())
+      return nullptr;
+    return &lives[it->second];
+  };
+  auto blocked = [&](PhyRegister *reg) {
+    auto f = fixed(reg);
+    return f != nullptr && f->Overlap(cur);
+  };
+  // 按起点顺序分配, 已经结束的区间以后不会再和谁相交
+  auto prune = [&](PhyRegister *reg) -> std::vector<LiveRange *> & {
+    auto &bin = bins[reg];
+    bin.erase(std::remove_if(bin.begin(), bin.end(),
+                             [&](LiveRange *other) {
+                               return other->end() <= cur.start();
+                             }),
+              bin.end());
+    return bin;
+  };
+  auto place = [&](PhyRegister *reg) {
+    cur.assigned = reg;
+    bins[reg].push_back(&cur);
+  };
+
+  // 候选顺序: mv 另一端的寄存器, caller-saved, 其余
+  std::vector<PhyRegister *> candidates;
+  for (auto hint : hints[cur.reg]) {
+    PhyRegister *reg = dynamic_cast<PhyRegister *>(hint);
+    if (reg == nullptr) {
+      auto it = RegNum.index.find(hint);
+      if (it != RegNum.index.end() && it->second < lives.size())
+        reg = lives[it->second].assigned;
+    }
+    if (reg && std::find(regs.begin(), regs.end(), reg) != regs.end())
+      candidates.push_back(reg);
+  }
+  for (auto reg : regs)
+    if (callers.count(reg))
+      candidates.push_back(reg);
+  for (auto reg : regs)
+    if (!callers.count(reg))
+      candidates.push_back(reg);
+  for (auto reg : candidates) {
+    if (blocked(reg))
+      continue;
+    auto &bin = prune(reg);
+    if (std::none_of(bin.begin(), bin.end(),
+                     [&](LiveRange *other) { return other->Overlap(cur); })) {
+      place(reg);
+      return true;
+    }
+  }
+
+  // 没有空的 bin, 找一个挡路区间里最大溢出代价最小的寄存器
+  PhyRegister *best = nullptr;
+  double bestCost = std::numeric_limits<double>::infinity();
+  for (auto reg : regs) {
+    if (blocked(reg))
+      continue;
+    double cost = 0;
+    for (auto other : bins[reg])
+      if (other->Overlap(cur))
+        cost = std::max(cost, other->weight);
+    if (cost < bestCost) {
+      bestCost = cost;
+      best = reg;
+    }
+  }
+  if (best == nullptr || bestCost >= cur.weight) {
+    assert(cur.weight != std::numeric_limits<double>::infinity() &&
+           "no register left for an unspillable interval");
+    return false;
+  }
+  auto &bin = bins[best];
+  for (auto other : bin)
+    if (other->Overlap(cur)) {
+      other->assigned = nullptr;
+      spilled.insert(dynamic_cast<VirRegister *>(other->reg));
+    }
+  bin.erase(std::remove_if(bin.begin(), bin.end(),
+                           [&](LiveRange *other) {
+                             return other->assigned == nullptr;
+                           }),
+            bin.end());
+  place(best);
+  return true;
+}
+
+void LinearScan::RewriteSpills() {
+  std::vector<RISCVBasicBlock *> blocks;
+  for (RISCVBasicBlock *block : *m_func)
+    blocks.push_back(block);
+  std::unordered_set<VirRegister *> temps;
+  rewriter.Rewrite(blocks, spilled, remat, temps, unspillable);
+}
+
+void LinearScan::RewriteProgram() {
+  auto assigned = [&](Register *reg) -> PhyRegister * {
+    auto it = RegNum.index.find(reg);
+    if (it == RegNum.index.end() || it->second >= lives.size())
+      return nullptr;
+    return lives[it->second].assigned;
+  };
+  std::vector<RISCVMIR *> coalesced;
+  for (RISCVBasicBlock *block : *m_func) {
+    for (RISCVMIR *mir : *block) {
+      if (mir->GetOpcode() == RISCVMIR::call)
+        continue;
+      if (auto vreg = dynamic_cast<VirRegister *>(mir->GetDef())) {
+        PhyRegister *replace = assigned(vreg);
+        assert(replace && "vreg defined without a register");
+        mir->SetDef(replace);
+      }
+      for (int i = 0; i < mir->GetOperandSize(); i++) {
+        auto operand = mir->GetOperand(i);
+        if (auto vreg = dynamic_cast<VirRegister *>(operand)) {
+          // ret 上挂着的返回值只用来区分 a0/fa0
+          if (PhyRegister *replace = assigned(vreg))
+            mir->SetOperand(i, replace);
+          else
+            assert(mir->GetOpcode() == RISCVMIR::ret &&
+                   "vreg used without a register");
+        } else if (auto lareg = dynamic_cast<LARegister *>(operand)) {
+          if (lareg->GetVreg() == nullptr)
+            continue;
+          PhyRegister *replace = assigned(lareg->GetVreg());
+          assert(replace);
+          lareg->SetReg(replace);
+        } else if (auto stackreg = dynamic_cast<StackRegister *>(operand)) {
+          if (stackreg->GetVreg() == nullptr)
+            continue;
+          PhyRegister *replace = assigned(stackreg->GetVreg());
+          assert(replace);
+          stackreg->SetPreg(replace);
+        }
+      }
+      if ((mir->GetOpcode() == RISCVMIR::mv ||
+           mir->GetOpcode() == RISCVMIR::_fmv_s) &&
+          mir->GetDef() == mir->GetOperand(0))
+        coalesced.push_back(mir);
+    }
+  }
+  for (auto mir : coalesced)
+    delete mir;
+}
+
+void LinearScan::RunOnFunc() {
+  for (auto reg : reglist.GetReglistCaller())
+    callers.insert(reg);
+  while (true) {
+    RegNum.clear();
+    Uses.clear();
+    Defs.clear();
+    BlockLivein.clear();
+    BlockLiveout.clear();
+    RunOnFunction();
+    BuildIntervals();
+    if (Allocate())
+      break;
+    RewriteSpills();
+  }
+  RewriteProgram();
+}
@@ -10,6 +10,73 @@
 using BlockInfo = BlockLiveInfo;
 using InterVal = LiveInterval;
 using OpType = RISCVMIR::RISCVISA;
+bool BitVector::operator|=(const BitVector &other) {
+  if (other.words.size() > words.size())
+    words.resize(other.words.size());
+  bool changed = false;
+  for (int i = 0; i < other.words.size(); i++) {
+    uint64_t merged = words[i] | other.words[i];
+    changed |= merged != words[i];
+    words[i] = merged;
+  }
+  return changed;
+}
+
+void BitVector::subtract(const BitVector &other) {
+  for (int i = 0; i < std::min(words.size(), other.words.size()); i++)
+    words[i] &= ~other.words[i];
+}
+
+bool BitVector::operator==(const BitVector &other) const {
+  size_t n = std::max(words.size(), other.words.size());
+  for (size_t i = 0; i < n; i++) {
+    uint64_t a = i < words.size() ? words[i] : 0;
+    uint64_t b = i < other.words.size() ? other.words[i] : 0;
+    if (a != b)
+      return false;
+  }
+  return true;
+}
+
+void InterferenceGraph::Grow(int i) {
+  if (i >= adj.size()) {
+    adj.resize(i + 1);
+    present.resize(i + 1);
+  }
+  size_t words = (Bit(i + 1, 0) + 63) / 64;
+  if (words > matrix.size())
+    matrix.resize(std::max(words, matrix.size() * 2));
+}
+
+bool InterferenceGraph::Interfere(MOperand a, MOperand b) {
+  int i = num(a), j = num(b);
+  if (i == j)
+    return false;
+  size_t bit = Bit(i, j);
+  return (bit >> 6) < matrix.size() && (matrix[bit >> 6] >> (bit & 63) & 1);
+}
+
+void InterferenceGraph::AddEdge(MOperand a, MOperand b) {
+  int i = num(a), j = num(b);
+  if (i == j)
+    return;
+  Grow(std::max(i, j));
+  size_t bit = Bit(i, j);
+  if (matrix[bit >> 6] >> (bit & 63) & 1)
+    return;
+  matrix[bit >> 6] |= 1ull << (bit & 63);
+  adj[i].push_back(b);
+  adj[j].push_back(a);
+  present[i] = present[j] = true;
+}
+
+std::vector<MOperand> &InterferenceGraph::operator[](MOperand op) {
+  int i = num(op);
+  Grow(i);
+  present[i] = true;
+  return adj[i];
+}
+
 bool BlockInfo::Count(Register *op) {
   if (op) {
     if (color.find(op) != color.end())
@@ -21,16 +88,22 @@ bool BlockInfo::Count(Register *op) {
 }
 void BlockInfo::UpdateInfo(RISCVMOperand *val, RISCVBasicBlock *block) {
   if (auto reg = val->ignoreLA()) {
-    if (Count(reg)) {
-      BlockLivein[block].insert(color[reg]);
-      Uses[block].insert(color[reg]);
-    } else {
-      BlockLivein[block].insert(reg);
-      Uses[block].insert(reg);
-    }
+    if (Count(reg))
+      reg = color[reg];
+    Uses[block].set(RegNum(reg));
   }
 }
+/// @brief 倒着走一遍块, 求出向上暴露的 use 和块里所有的 def, 之后迭代时不再看指令
 void BlockInfo::GetBlockLivein(RISCVBasicBlock *block) {
+  auto kill = [&](RISCVMOperand *_DefValue) {
+    if (auto DefValue = _DefValue->ignoreLA()) {
+      if (Count(DefValue))
+        DefValue = color[DefValue];
+      int index = RegNum(DefValue);
+      Uses[block].reset(index);
+      Defs[block].set(index);
+    }
+  };
   for (auto inst = block->rbegin(); inst != block->rend(); --inst) {
     OpType Opcode = (*inst)->GetOpcode();
     if (Opcode == OpType::_j)
@@ -48,15 +121,16 @@ void BlockInfo::GetBlockLivein(RISCVBasicBlock *block) {
         RISCVMOperand *val1 = (*inst)->GetOperand(0);
         if (val1->GetType() == RISCVType::riscv_i32) {
           PhyRegister *Phy = PhyRegister::GetPhyReg(PhyRegister::PhyReg::a0);
-          BlockLivein[block].insert(Phy);
-          Uses[block].insert(Phy);
+          Uses[block].set(RegNum(Phy));
         } else if (val1->GetType() == RISCVType::riscv_float32) {
           PhyRegister *Phy = PhyRegister::GetPhyReg(PhyRegister::PhyReg::fa0);
-          BlockLivein[block].insert(Phy);
-          Uses[block].insert(Phy);
+          Uses[block].set(RegNum(Phy));
         }
       }
     } else if (Opcode == OpType::call) {
+      // 调用破坏所有 caller-saved, 调用之后读的 a0 不会再往前活跃
+      for (auto reg : RegisterList::GetPhyRegList().GetReglistCaller())
+        kill(reg);
       for (int i = 0; i < (*inst)->GetOperandSize(); i++) {
         RISCVMOperand *val = (*inst)->GetOperand(i);
         if (val) {
@@ -66,44 +140,24 @@ void BlockInfo::GetBlockLivein(RISCVBasicBlock *block) {
       // continue;
     } else if ((*inst)->GetOperandSize() == 1) {
       RISCVMOperand *_val = (*inst)->GetOperand(0);
+      // walking backwards: kill the def before adding the uses
+      if (RISCVMOperand *_DefValue = (*inst)->GetDef())
+        kill(_DefValue);
       UpdateInfo(_val, block);
-      if (RISCVMOperand *_DefValue = (*inst)->GetDef()) {
-        if (auto DefValue = _DefValue->ignoreLA()) {
-          if (Count(DefValue)) {
-            BlockLivein[block].erase(color[DefValue]);
-            Uses[block].erase(color[DefValue]);
-            Defs[block].insert(color[DefValue]);
-          } else {
-            BlockLivein[block].erase(DefValue);
-            Uses[block].erase(DefValue);
-            Defs[block].insert(DefValue);
-          }
-        }
-      }
     } else if ((*inst)->GetOperandSize() > 1) {
       RISCVMOperand *_val1 = (*inst)->GetOperand(0);
       RISCVMOperand *_val2 = (*inst)->GetOperand(1);
+      if (auto DefValue_ = (*inst)->GetDef())
+        kill(DefValue_);
       UpdateInfo(_val1, block);
       UpdateInfo(_val2, block);
-      if (auto DefValue_ = (*inst)->GetDef()) {
-        if (auto DefValue = DefValue_->ignoreLA()) {
-          if (Count(DefValue)) {
-            BlockLivein[block].erase(color[DefValue]);
-            Uses[block].erase(color[DefValue]);
-            Defs[block].insert(color[DefValue]);
-          } else {
-            BlockLivein[block].erase(DefValue);
-            Uses[block].erase(DefValue);
-            Defs[block].insert(DefValue);
-          }
-        }
-      }
     }
   }
 }
 
 void BlockInfo::GetBlockLiveout(RISCVBasicBlock *block) {
-
+  auto &succs = SuccBlocks[block];
+  succs.clear();
   for (RISCVMIR *inst : *block) {
     OpType Opcode = inst->GetOpcode();
     if (Opcode == OpType::_j) {
@@ -112,18 +166,14 @@ void BlockInfo::GetBlockLiveout(RISCVBasicBlock *block) {
         _block_Succ = dynamic_cast<RISCVBasicBlock *>(inst->GetDef());
       else if (inst->GetOperand(0))
         _block_Succ = dynamic_cast<RISCVBasicBlock *>(inst->GetOperand(0));
-      BlockLiveout[block].insert(BlockLivein[_block_Succ].begin(),
-                                 BlockLivein[_block_Succ].end());
-      SuccBlocks[block].push_front(_block_Succ);
+      succs.push_front(_block_Succ);
     } else if (Opcode == OpType::_beq || Opcode == OpType::_bne ||
                Opcode == OpType::_blt || Opcode == OpType::_bge ||
                Opcode == OpType::_bltu || Opcode == OpType::_bgeu ||
                Opcode == OpType::_bgt || Opcode == OpType::_ble) {
       RISCVBasicBlock *_block_Succ1 =
           dynamic_cast<RISCVBasicBlock *>(inst->GetOperand(2));
-      BlockLiveout[block].insert(BlockLivein[_block_Succ1].begin(),
-                                 BlockLivein[_block_Succ1].end());
-      SuccBlocks[block].push_front(_block_Succ1);
+      succs.push_front(_block_Succ1);
     }
   }
 }
@@ -134,6 +184,7 @@ void BlockInfo::RunOnFunction() {
     BlockLiveout[_block].clear();
     GetBlockLivein(_block);
     GetBlockLiveout(_block);
+    BlockLivein[_block] = Uses[_block];
   }
   iterate(m_func);
   while (isChanged)
@@ -142,7 +193,7 @@ void BlockInfo::RunOnFunction() {
 
 void BlockInfo::iterate(RISCVFunction *func) {
   RunOnFunc(func);
-  bool isChanged = false;
+  isChanged = false;
   for (RISCVBasicBlock *_block : *func) {
     if (!UnChanged[_block]) {
       isChanged = true;
@@ -151,23 +202,39 @@ void BlockInfo::iterate(RISCVFunction *func) {
   }
 }
 
+/// @brief out = 后继 in 的并, in = use | (out - def)
 void BlockInfo::RunOnFunc(RISCVFunction *func) {
   for (auto BB = func->rbegin(); BB != func->rend(); --BB) {
     RISCVBasicBlock *_Block = *BB;
-    std::set<MOperand> old_BlockLivein = BlockLivein[_Block];
-    std::set<MOperand> old_BlockLiveout = BlockLiveout[_Block];
-    GetBlockLiveout(_Block);
-    BlockLivein[_Block] = BlockLiveout[_Block];
-    GetBlockLivein(_Block);
-    if (BlockLivein[_Block] == old_BlockLivein)
-      UnChanged[_Block] = true;
-    else
-      UnChanged[_Block] = false;
+    auto &out = BlockLiveout[_Block];
+    for (auto succ : SuccBlocks[_Block])
+      out |= BlockLivein[succ];
+    BitVector in = out;
+    in.subtract(Defs[_Block]);
+    in |= Uses[_Block];
+    UnChanged[_Block] = in == BlockLivein[_Block];
+    if (!UnChanged[_Block])
+      BlockLivein[_Block] = std::move(in);
   }
 }
 
 void GraphColor::CalInstLive(RISCVBasicBlock *block) {
-  std::set<MOperand> Live = BlockLiveout[block];
+  BitVector Live = BlockLiveout[block];
+  // 操作数是 use 时登记到 initial/Precolored 并加入 Live
+  auto use = [&](MOperand val) {
+    if (Count(val)) {
+      Precolored.insert(color[val]);
+      color[color[val]] = color[val];
+    } else {
+      initial.insert(val);
+      if (auto phy = dynamic_cast<PhyRegister *>(val)) {
+        Precolored.insert(phy);
+        color[phy] = phy;
+        initial.erase(val);
+      }
+    }
+    Live.set(RegNum(val));
+  };
   for (auto inst_ = block->rbegin(); inst_ != block->rend(); --inst_) {
     RISCVMIR *inst = *inst_;
     if (RISCVMOperand *_DefValue = inst->GetDef()) {
@@ -180,131 +247,64 @@ void GraphColor::CalInstLive(RISCVBasicBlock *block) {
         }
 
         if (Count(DefValue)) {
-          Live.erase(DefValue);
+          Live.reset(RegNum(DefValue));
           color[color[DefValue]] = color[DefValue];
           Precolored.insert(color[DefValue]);
         } else {
           if (auto phy = dynamic_cast<PhyRegister *>(DefValue)) {
             Precolored.insert(phy);
             color[phy] = phy;
-            Live.erase(DefValue);
-          } else
-            Live.erase(DefValue);
+          }
+          Live.reset(RegNum(DefValue));
         }
       }
     }
     if (inst->GetOpcode() == OpType::call) {
-      InstLive[inst] = Live;
+      BitVector InstLive = Live;
       for (auto reg : reglist.GetReglistCaller()) {
         Precolored.insert(reg);
         color[reg] = reg;
-        // InstLive[inst].insert(reg);
-        Live.erase(reg);
+        Live.reset(RegNum(reg));
       }
       for (int i = 0; i < inst->GetOperandSize(); i++) {
         RISCVMOperand *val = inst->GetOperand(i);
         if (auto reg = val->ignoreLA()) {
-          if (reg) {
-            // if (auto phy = dynamic_cast<PhyRegister *>(reg)) {
-            //   Precolored.insert(phy);a
-            //   color[phy] = phy;
-            // }
-            if (Count(reg)) {
-              Precolored.insert(color[reg]);
-              color[color[reg]] = color[reg];
-              Live.insert(reg);
-              InstLive[inst].insert(reg);
-            } else {
-              // Live.insert(reg);
-              // InstLive[inst].insert(reg);
-              // initial.insert(reg);
-              if (auto phy = dynamic_cast<PhyRegister *>(reg)) {
-                Precolored.insert(phy);
-                color[phy] = phy;
-                initial.erase(reg);
-                Live.insert(phy);
-                InstLive[inst].insert(phy);
-              }
-            }
-            // Live.insert(reg);
-            // InstLive[inst].insert(reg);
+          if (Count(reg)) {
+            Precolored.insert(color[reg]);
+            color[color[reg]] = color[reg];
+            Live.set(RegNum(reg));
+            InstLive.set(RegNum(reg));
+          } else if (auto phy = dynamic_cast<PhyRegister *>(reg)) {
+            Precolored.insert(phy);
+            color[phy] = phy;
+            initial.erase(reg);
+            Live.set(RegNum(phy));
+            InstLive.set(RegNum(phy));
           }
         }
       }
-      CalcIG(inst);
+      CalcIG(inst, InstLive);
       continue;
     } else if (inst->GetOperandSize() == 1) {
       if (inst->GetOpcode() == OpType::ret) {
         RISCVMOperand *val1 = inst->GetOperand(0);
         if (val1) {
           PhyRegister *Phy = PhyRegister::GetPhyReg(PhyRegister::PhyReg::a0);
-          Live.insert(Phy);
+          Live.set(RegNum(Phy));
           Precolored.insert(Phy);
           color[Phy] = Phy;
-          InstLive[inst] = Live;
-          CalcIG(inst);
+          CalcIG(inst, Live);
           continue;
         }
-      } else {
-        RISCVMOperand *_val1 = inst->GetOperand(0);
-        if (auto val1 = _val1->ignoreLA()) {
-          if (Count(val1)) {
-            Precolored.insert(color[val1]);
-            color[color[val1]] = color[val1];
-            Live.insert(val1);
-          } else {
-            Live.insert(val1);
-                        if(val1->GetName() == ".130")
-              int b =1;
-            initial.insert(val1);
-            if (auto phy = dynamic_cast<PhyRegister *>(val1)) {
-              Precolored.insert(phy);
-              color[phy] = phy;
-              initial.erase(val1);
-            }
-          }
-        }
-      }
+      } else if (auto val1 = inst->GetOperand(0)->ignoreLA())
+        use(val1);
     } else if (inst->GetOperandSize() > 1) {
-      RISCVMOperand *_val1 = inst->GetOperand(0);
-      RISCVMOperand *_val2 = inst->GetOperand(1);
-      if (auto val1 = _val1->ignoreLA()) {
-        if (Count(val1)) {
-          Precolored.insert(color[val1]);
-          color[color[val1]] = color[val1];
-          Live.insert(val1);
-        } else {
-          Live.insert(val1);
-                      if(val1->GetName() == ".130")
-              int b =1;
-          initial.insert(val1);
-          if (auto phy = dynamic_cast<PhyRegister *>(val1)) {
-            color[phy] = phy;
-            Precolored.insert(phy);
-            initial.erase(val1);
-          }
-        }
-      }
-      if (auto val2 = _val2->ignoreLA()) {
-        if (Count(val2)) {
-          Precolored.insert(color[val2]);
-          color[color[val2]] = color[val2];
-          Live.insert(val2);
-        } else {
-          Live.insert(val2);
-                      if(val2->GetName() == ".130")
-              int b =1;
-          initial.insert(val2);
-          if (auto phy = dynamic_cast<PhyRegister *>(val2)) {
-            color[phy] = phy;
-            Precolored.insert(phy);
-            initial.erase(val2);
-          }
-        }
-      }
+      if (auto val1 = inst->GetOperand(0)->ignoreLA())
+        use(val1);
+      if (auto val2 = inst->GetOperand(1)->ignoreLA())
+        use(val2);
     }
-    InstLive[inst] = Live;
-    CalcIG(inst);
+    CalcIG(inst, Live);
   }
 }
 void GraphColor::CalcmoveList(RISCVBasicBlock *block) {
@@ -328,26 +328,18 @@ void GraphColor::CalcmoveList(RISCVBasicBlock *block) {
   }
 }
 
-void GraphColor::CalcIG(RISCVMIR *inst) {
+void GraphColor::CalcIG(RISCVMIR *inst, BitVector &live) {
   if (inst->GetOpcode() == RISCVMIR::call) {
     for (auto reg : reglist.GetReglistCaller())
-      InstLive[inst].insert(reg);
+      live.set(RegNum(reg));
   }
-  if (InstLive[inst].size() > 1) {
-    for (auto *Op1 : InstLive[inst]) {
-      for (auto *Op2 : InstLive[inst]) {
-        if (Op1->GetName() == ".101" || Op2->GetName() == ".101")
-          int c = 1;
-        if (Op1 && Op2 && Op2 != Op1)
-          PushVecSingleVal(IG[Op1], Op2);
-      }
-    }
-  } else if (InstLive[inst].size() == 1) {
-    auto op1 = *InstLive[inst].begin();
-    if (op1)
-      IG[op1];
-  } else
-    return;
+  std::vector<MOperand> regs;
+  live.visit([&](int i) { regs.push_back(RegNum[i]); });
+  if (regs.size() == 1)
+    IG[regs[0]];
+  for (int i = 0; i < regs.size(); i++)
+    for (int j = i + 1; j < regs.size(); j++)
+      IG.AddEdge(regs[i], regs[j]);
 }
 void BlockInfo::PrintPass() {
   std::cout << "--------BlockLiveInfo--------" << std::endl;
@@ -355,23 +347,19 @@ void BlockInfo::PrintPass() {
     std::cout << "--------Block:" << _block->GetName() << "--------"
               << std::endl;
     std::cout << "        Livein" << std::endl;
-    for (RISCVMOperand *_value : BlockLivein[_block]) {
-      if (dynamic_cast<VirRegister *>(_value))
-        _value->print();
-      else
-        _value->print();
-      std::cout << " ";
-    }
-    std::cout << std::endl;
+    AsmEmitter out;
+    BlockLivein[_block].visit([&](int i) {
+      RegNum[i]->print(out);
+      out << " ";
+    });
+    std::cout << out.str() << std::endl;
     std::cout << "        Liveout" << std::endl;
-    for (RISCVMOperand *_value : BlockLiveout[_block]) {
-      if (dynamic_cast<VirRegister *>(_value))
-        _value->print();
-      else
-        _value->print();
-      std::cout << " ";
-    }
-    std::cout << std::endl;
+    out = AsmEmitter();
+    BlockLiveout[_block].visit([&](int i) {
+      RegNum[i]->print(out);
+      out << " ";
+    });
+    std::cout << out.str() << std::endl;
   }
 }
 
@@ -412,63 +400,38 @@ void InterVal::init() {
   }
 }
 
-void InterVal::computeLiveIntervals()
-
-{
+/// @brief 每块倒着扫一遍求出每条指令处的活跃集合, 再正着把连续活跃的指令拼成区间
+void InterVal::computeLiveIntervals() {
   for (RISCVBasicBlock *block : *func) {
+    std::vector<RISCVMIR *> insts;
+    for (RISCVMIR *inst : *block)
+      insts.push_back(inst);
+    std::vector<BitVector> InstLive(insts.size());
+    BitVector Live = BlockLiveout[block];
+    for (int i = (int)insts.size() - 1; i >= 0; i--) {
+      RISCVMIR *inst = insts[i];
+      if (inst->GetDef())
+        if (auto def = inst->GetDef()->ignoreLA())
+          Live.reset(RegNum(def));
+      for (int j = 0; j < inst->GetOperandSize(); j++)
+        if (inst->GetOperand(j))
+          if (auto reg = inst->GetOperand(j)->ignoreLA())
+            Live.set(RegNum(reg));
+      InstLive[i] = Live;
+    }
     std::unordered_map<MOperand, std::vector<Interval>> CurrentRegLiveinterval;
-    int begin = -1;
-    for (RISCVMIR *inst : *block) {
-      int Curr = instNum[inst];
-      if (inst == block->front())
-        begin = instNum[inst];
-      for (MOperand Op : InstLive[inst]) {
-        if (!CurrentRegLiveinterval.count(Op)) {
-          Interval interval;
-          interval.start = Curr;
-          interval.end = -1;
-          CurrentRegLiveinterval[Op].push_back(interval);
-        } else {
-          if (CurrentRegLiveinterval[Op].back().end == -1 &&
-              inst == block->back())
-            CurrentRegLiveinterval[Op].back().end = Curr;
-          else if (CurrentRegLiveinterval[Op].back().end != -1 &&
-                   count(Op, inst)) {
-            Interval interval;
-            interval.start = Curr;
-            interval.end = -1;
-            CurrentRegLiveinterval[Op].push_back(interval);
-          }
-        }
-      }
-      for (auto &[Op, intervals] : CurrentRegLiveinterval) {
-        if (intervals.back().end == -1 && inst == block->back() &&
-            !count(Op, inst))
-          CurrentRegLiveinterval[Op].back().end = Curr - 1;
-        else if (intervals.back().end == -1 && inst == block->back())
-          CurrentRegLiveinterval[Op].back().end = Curr;
-        else if (intervals.back().end == -1 && !count(Op, inst))
-          intervals.back().end = Curr - 1;
-        else if (intervals.back().end == -1 && count(Op, inst))
-          continue;
-      }
+    for (int i = 0; i < insts.size(); i++) {
+      int Curr = instNum[insts[i]];
+      InstLive[i].visit([&](int id) {
+        auto &intervals = CurrentRegLiveinterval[RegNum[id]];
+        if (!intervals.empty() && intervals.back().end == Curr - 1)
+          intervals.back().end = Curr;
+        else
+          intervals.push_back(Interval{Curr, Curr});
+      });
     }
-    if (verify(CurrentRegLiveinterval)) {
-      for (auto &[op, intervals] : CurrentRegLiveinterval) {
-        auto curr = intervals.begin();
-        for (auto iter = intervals.begin(); iter != intervals.end(); ++iter) {
-          if (iter == curr)
-            continue;
-          if (curr->start < iter->start) {
-            ++curr;
-            *curr = *iter;
-          } else
-            curr->end = std::max(curr->end, iter->end);
-        }
-        intervals.erase(std::next(curr), intervals.end());
-      }
+    if (verify(CurrentRegLiveinterval))
       RegLiveness[block] = CurrentRegLiveinterval;
-    }
   }
 }
 
@@ -521,32 +484,16 @@ bool InterVal::verify(
 // }
 
 void InterVal::PrintAnalysis() {
-  std::cout << "--------InstLive--------" << std::endl;
-  for (RISCVBasicBlock *block : *func) {
-    std::cout << "-----Block " << block->GetName() << "-----" << std::endl;
-    for (RISCVMIR *inst : *block) {
-      std::cout << "inst" << instNum[inst] << "Liveness:";
-      for (RISCVMOperand *Op : InstLive[inst]) {
-        if (dynamic_cast<VirRegister *>(Op))
-          Op->print();
-        else
-          Op->print();
-      }
-      std::cout << std::endl;
-    }
-  }
   for (RISCVBasicBlock *block : *func) {
     std::cout << "--------LiveInterval--------" << std::endl;
     std::cout << "--------Block:" << block->GetName() << "--------"
               << std::endl;
     for (auto &[op, intervals] : RegLiveness[block]) {
-      if (dynamic_cast<VirRegister *>(op))
-        op->print();
-      else
-        op->print();
+      AsmEmitter out;
+      op->print(out);
       for (auto &i : intervals)
-        std::cout << "[" << i.start << "," << i.end << "]";
-      std::cout << std::endl;
+        out << "[" << i.start << "," << i.end << "]";
+      std::cout << out.str() << std::endl;
     }
   }
 }
@@ -563,7 +510,6 @@ void GraphColor::LiveInfoInit() {
   instNum.clear();
   Uses.clear();
   Defs.clear();
-  InstLive.clear();
   IG.clear();
   ValsInterval.clear();
   freezeWorkList.clear();
@@ -571,6 +517,7 @@ void GraphColor::LiveInfoInit() {
   simplifyWorkList.clear();
   spillWorkList.clear();
   spillWorkList.clear();
+  SpillQueue = {};
   spilledNodes.clear();
   initial.clear();
   coalescedNodes.clear();
@@ -578,19 +525,18 @@ void GraphColor::LiveInfoInit() {
   coalescedMoves.clear();
   frozenMoves.clear();
   coloredNode.clear();
-  AdjList.clear();
   selectstack.clear();
+  selected.clear();
   belongs.clear();
   activeMoves.clear();
   alias.clear();
   RegType.clear();
-  AlreadySpill.clear();
-  InstLive.clear();
   Precolored.clear();
   color.clear();
   moveList.clear();
   IG.clear();
+  RegNum.clear();
   instNum.clear();
   RegLiveness.clear();
   assist.clear();
-}
\ No newline at end of file
+}
\ No newline at end of file
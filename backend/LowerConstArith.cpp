@@ -0,0 +1,227 @@
+#include "../include/backend/RISCVISel.hpp"
+#include <climits>
+#include <cstdint>
+
+/// @brief 乘除常数的指令选择
+/// @note 除法用 Hacker's Delight 的有符号魔数, RV64 上直接用 64 位 mul 拿到完整乘积再 srai 32 位, 省掉 mulh
+/// @note 操作数都是符号扩展过的 32 位数, 中间结果用 w 指令保持这个性质
+
+namespace {
+struct Magic {
+    int multiplier;
+    int shift;
+};
+
+/// @brief 有符号除数 d 的魔数, d 不能是 -1, 0, 1
+Magic SignedMagic(int d) {
+    const uint32_t two31 = 0x80000000u;
+    uint32_t ad = d < 0 ? -(uint32_t)d : d;
+    uint32_t t = two31 + ((uint32_t)d >> 31);
+    uint32_t anc = t - 1 - t % ad;
+    int p = 31;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / ad, r2 = two31 - q2 * ad;
+    uint32_t delta;
+    do {
+        p++;
+        q1 *= 2, r1 *= 2;
+        if (r1 >= anc) q1++, r1 -= anc;
+        q2 *= 2, r2 *= 2;
+        if (r2 >= ad) q2++, r2 -= ad;
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    int m = (int)(q2 + 1);
+    return {d < 0 ? -m : m, p - 32};
+}
+
+int Log2(uint32_t x) {
+    if (x == 0 || (x & (x - 1))) return -1;
+    int k = 0;
+    while (x >>= 1) k++;
+    return k;
+}
+
+RISCVMOperand* ImmOf(int val) {
+    return Imm::GetImm(ConstIRInt::GetNewConstant(val));
+}
+
+RISCVMOperand* Zero() {
+    return PhyRegister::GetPhyReg(PhyRegister::PhyReg::zero);
+}
+
+void Emit(RISCVLoweringContext& ctx, RISCVMIR::RISCVISA isa, RISCVMOperand* def,
+          RISCVMOperand* lhs, RISCVMOperand* rhs = nullptr) {
+    auto minst = new RISCVMIR(isa);
+    minst->SetDef(def);
+    minst->AddOperand(lhs);
+    if (rhs) minst->AddOperand(rhs);
+    ctx(minst);
+}
+
+/// @brief dst = src * c, 只接受最多 3 条移位/加减的情况
+/// @note 按 mod 2^32 看 c, 负数用取反后的形式, 和 mulw 的回绕一致
+bool EmitMulConst(RISCVLoweringContext& ctx, RISCVMOperand* dst, RISCVMOperand* src, int c) {
+    uint32_t u = c, nu = -u;
+    // 结果不用到 src 时留给 mulw, 不然 src 的定值就成了死定值, 分配器不认
+    if (u == 0) return false;
+    if (u == 1) {
+        Emit(ctx, RISCVMIR::mv, dst, src);
+        return true;
+    }
+    if (nu == 1) {
+        Emit(ctx, RISCVMIR::_subw, dst, Zero(), src);
+        return true;
+    }
+    if (int k = Log2(u); k > 0) {
+        Emit(ctx, RISCVMIR::_slliw, dst, src, ImmOf(k));
+        return true;
+    }
+    // 2^k+1, 2^k-1
+    if (int k = Log2(u - 1); k > 0) {
+        auto t = ctx.createVReg(riscv_i32);
+        Emit(ctx, RISCVMIR::_slliw, t, src, ImmOf(k));
+        Emit(ctx, RISCVMIR::_addw, dst, t, src);
+        return true;
+    }
+    if (int k = Log2(u + 1); k > 0) {
+        auto t = ctx.createVReg(riscv_i32);
+        Emit(ctx, RISCVMIR::_slliw, t, src, ImmOf(k));
+        Emit(ctx, RISCVMIR::_subw, dst, t, src);
+        return true;
+    }
+    // -(2^k), -(2^k-1)
+    if (int k = Log2(nu); k > 0) {
+        auto t = ctx.createVReg(riscv_i32);
+        Emit(ctx, RISCVMIR::_slliw, t, src, ImmOf(k));
+        Emit(ctx, RISCVMIR::_subw, dst, Zero(), t);
+        return true;
+    }
+    if (int k = Log2(nu + 1); k > 0) {
+        auto t = ctx.createVReg(riscv_i32);
+        Emit(ctx, RISCVMIR::_slliw, t, src, ImmOf(k));
+        Emit(ctx, RISCVMIR::_subw, dst, src, t);
+        return true;
+    }
+    // 2^a+2^b, -(2^k+1)
+    uint32_t low = u & -u;
+    if (int a = Log2(u - low), b = Log2(low); a > 0 && b > 0) {
+        auto t1 = ctx.createVReg(riscv_i32);
+        auto t2 = ctx.createVReg(riscv_i32);
+        Emit(ctx, RISCVMIR::_slliw, t1, src, ImmOf(a));
+        Emit(ctx, RISCVMIR::_slliw, t2, src, ImmOf(b));
+        Emit(ctx, RISCVMIR::_addw, dst, t1, t2);
+        return true;
+    }
+    if (int k = Log2(nu - 1); k > 0) {
+        auto t1 = ctx.createVReg(riscv_i32);
+        auto t2 = ctx.createVReg(riscv_i32);
+        Emit(ctx, RISCVMIR::_slliw, t1, src, ImmOf(k));
+        Emit(ctx, RISCVMIR::_addw, t2, t1, src);
+        Emit(ctx, RISCVMIR::_subw, dst, Zero(), t2);
+        return true;
+    }
+    return false;
+}
+
+/// @brief 负数被除数加上 2^k-1, 使右移变成向零取整
+RISCVMOperand* EmitRoundBias(RISCVLoweringContext& ctx, RISCVMOperand* n, int k) {
+    auto bias = ctx.createVReg(riscv_i32);
+    if (k == 1)
+        Emit(ctx, RISCVMIR::_srliw, bias, n, ImmOf(31));
+    else {
+        auto sign = ctx.createVReg(riscv_i32);
+        Emit(ctx, RISCVMIR::_sraiw, sign, n, ImmOf(31));
+        Emit(ctx, RISCVMIR::_srliw, bias, sign, ImmOf(32 - k));
+    }
+    auto biased = ctx.createVReg(riscv_i32);
+    Emit(ctx, RISCVMIR::_addw, biased, n, bias);
+    return biased;
+}
+
+/// @brief dst = n / d, d 不是 0, ±1, INT_MIN
+void EmitDivConst(RISCVLoweringContext& ctx, RISCVMOperand* dst, RISCVMOperand* n, int d) {
+    uint32_t ad = d < 0 ? -(uint32_t)d : d;
+    if (int k = Log2(ad); k > 0) {
+        auto biased = EmitRoundBias(ctx, n, k);
+        if (d > 0)
+            Emit(ctx, RISCVMIR::_sraiw, dst, biased, ImmOf(k));
+        else {
+            auto q = ctx.createVReg(riscv_i32);
+            Emit(ctx, RISCVMIR::_sraiw, q, biased, ImmOf(k));
+            Emit(ctx, RISCVMIR::_subw, dst, Zero(), q);
+        }
+        return;
+    }
+    auto [m, s] = SignedMagic(d);
+    auto mreg = ctx.createVReg(riscv_i32);
+    Emit(ctx, RISCVMIR::li, mreg, ImmOf(m));
+    auto prod = ctx.createVReg(riscv_i32);
+    Emit(ctx, RISCVMIR::_mul, prod, n, mreg);
+    auto q = ctx.createVReg(riscv_i32);
+    if ((d > 0 && m < 0) || (d < 0 && m > 0)) {
+        auto hi = ctx.createVReg(riscv_i32);
+        Emit(ctx, RISCVMIR::_srai, hi, prod, ImmOf(32));
+        auto fixed = s ? ctx.createVReg(riscv_i32) : q;
+        Emit(ctx, d > 0 ? RISCVMIR::_addw : RISCVMIR::_subw, fixed, hi, n);
+        if (s) Emit(ctx, RISCVMIR::_sraiw, q, fixed, ImmOf(s));
+    } else
+        Emit(ctx, RISCVMIR::_srai, q, prod, ImmOf(32 + s));
+    // 商为负时加 1, 向零取整
+    auto sign = ctx.createVReg(riscv_i32);
+    Emit(ctx, RISCVMIR::_srliw, sign, q, ImmOf(31));
+    Emit(ctx, RISCVMIR::_addw, dst, q, sign);
+}
+}  // namespace
+
+bool LowerConstMul(BinaryInst* inst, RISCVLoweringContext& ctx) {
+    Value* src = inst->GetOperand(0);
+    auto constint = dynamic_cast<ConstIRInt*>(inst->GetOperand(1));
+    if (constint == nullptr) {
+        constint = dynamic_cast<ConstIRInt*>(src);
+        src = inst->GetOperand(1);
+    }
+    if (constint == nullptr || dynamic_cast<ConstIRInt*>(src)) return false;
+    return EmitMulConst(ctx, ctx.mapping(inst), ctx.mapping(src), constint->GetVal());
+}
+
+bool LowerConstDiv(BinaryInst* inst, RISCVLoweringContext& ctx) {
+    auto constint = dynamic_cast<ConstIRInt*>(inst->GetOperand(1));
+    if (constint == nullptr || dynamic_cast<ConstIRInt*>(inst->GetOperand(0))) return false;
+    int d = constint->GetVal();
+    if (d == 0 || d == INT_MIN) return false;
+    auto dst = ctx.mapping(inst);
+    auto n = ctx.mapping(inst->GetOperand(0));
+    if (d == 1)
+        Emit(ctx, RISCVMIR::mv, dst, n);
+    else if (d == -1)
+        Emit(ctx, RISCVMIR::_subw, dst, Zero(), n);
+    else
+        EmitDivConst(ctx, dst, n, d);
+    return true;
+}
+
+/// @note n % d = n - (n / d) * d, 结果的符号跟被除数, 和 d 的符号无关
+bool LowerConstMod(BinaryInst* inst, RISCVLoweringContext& ctx) {
+    auto constint = dynamic_cast<ConstIRInt*>(inst->GetOperand(1));
+    if (constint == nullptr || dynamic_cast<ConstIRInt*>(inst->GetOperand(0))) return false;
+    int d = constint->GetVal();
+    if (d == 0 || d == INT_MIN) return false;
+    auto dst = ctx.mapping(inst);
+    auto n = ctx.mapping(inst->GetOperand(0));
+    uint32_t ad = d < 0 ? -(uint32_t)d : d;
+    if (ad == 1) return false;
+    if (int k = Log2(ad); k > 0) {
+        auto biased = EmitRoundBias(ctx, n, k);
+        auto masked = ctx.createVReg(riscv_i32);
+        Emit(ctx, RISCVMIR::_andi, masked, biased, ImmOf(-(int)ad));
+        Emit(ctx, RISCVMIR::_subw, dst, n, masked);
+        return true;
+    }
+    auto q = ctx.createVReg(riscv_i32);
+    EmitDivConst(ctx, q, n, d);
+    auto prod = ctx.createVReg(riscv_i32);
+    if (!EmitMulConst(ctx, prod, q, d))
+        Emit(ctx, RISCVMIR::_mulw, prod, q, ImmOf(d));
+    Emit(ctx, RISCVMIR::_subw, dst, n, prod);
+    return true;
+}
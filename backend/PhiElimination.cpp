@@ -13,6 +13,7 @@ RISCVBasicBlock* PhiElimination::find_copy_block(BasicBlock* from,BasicBlock* to
         auto mto=cxt.mapping(to)->as<RISCVBasicBlock>();
         
         auto critialmbb=RISCVBasicBlock::CreateRISCVBasicBlock();
+        critialmbb->LoopDepth=std::min(mfrom->LoopDepth,mto->LoopDepth);
         mfrom->replace_succ(mto,critialmbb);
         auto uncond=new RISCVMIR(RISCVMIR::_j);
         uncond->AddOperand(mto);
@@ -33,13 +34,22 @@ void PhiElimination::runOnGraph(BasicBlock* pred,BasicBlock* succ,std::vector<st
         std::forward_list<int> nxt;
         int indo=0;
     };
+    /// @note src 可能是 offset(reg) 形式的地址, 它读的是里面的 reg
+    auto read_reg=[](RISCVMOperand* src)->RISCVMOperand*{
+        if(auto sreg=dynamic_cast<StackRegister*>(src))
+            if(sreg->GetVreg()!=nullptr)
+                return sreg->GetVreg();
+        return src;
+    };
     std::map<RISCVMOperand*,int> mp;
     for(int i=0,limi=vec.size();i<limi;i++)
         mp[vec[i].second]=i;
     std::vector<Node> graph(vec.size());
     for(int i=0,limi=vec.size();i<limi;i++)
-        if(mp.find(vec[i].first)!=mp.end()){
-            auto src=i,dst=mp[vec[i].first];
+        if(mp.find(read_reg(vec[i].first))!=mp.end()){
+            auto src=i,dst=mp[read_reg(vec[i].first)];
+            // p=p+4 这种自己读自己的一条指令就能完成
+            if(src==dst)continue;
             graph[src].nxt.push_front(dst);
             graph[dst].indo++;
         }
@@ -67,8 +77,13 @@ void PhiElimination::runOnGraph(BasicBlock* pred,BasicBlock* succ,std::vector<st
             i++;
 
             auto [src,dst]=vec[ind];
-            if(stagedRegister.find(src)!=stagedRegister.end())
-                src=stagedRegister[src];
+            auto reg=read_reg(src);
+            if(stagedRegister.find(reg)!=stagedRegister.end()){
+                if(reg==src)
+                    src=stagedRegister[reg];
+                else
+                    src=new StackRegister(stagedRegister[reg]->as<VirRegister>(),src->as<StackRegister>()->GetOffset());
+            }
 
             if(graph[ind].indo!=0){
                 /// @note stage register
@@ -1,24 +1,27 @@
 #include "../include/backend/RISCVAsmPrinter.hpp"
+#include "../include/backend/RISCVObjectWriter.hpp"
+#include <atomic>
+#include <thread>
 
 SegmentType __oldtype=TEXT;
 SegmentType* oldtype = &__oldtype;
 SegmentType ChangeSegmentType(SegmentType newtype) {
     return newtype;
 }
-void PrintSegmentType(SegmentType newtype, SegmentType* oldtype) {
+void PrintSegmentType(AsmEmitter& out, SegmentType newtype, SegmentType* oldtype) {
     if (newtype == *oldtype) return;
     else {
         *oldtype = ChangeSegmentType(newtype);
         if (newtype == TEXT) 
-            std::cout << "    .text" << std::endl;
+            out << "    .text" << '\n';
         else if (newtype == DATA) 
-            std::cout << "    .data" << std::endl;
+            out << "    .data" << '\n';
         else if (newtype == BSS)
-            std::cout << "    .bss" << std::endl;
+            out << "    .bss" << '\n';
         else if (newtype == RODATA)
-            std::cout << "    .section    .rodata" << std::endl;
+            out << "    .section    .rodata" << '\n';
         else 
-            std::cout << "ERROR: Illegal SegmentType" << std::endl;
+            out << "ERROR: Illegal SegmentType" << '\n';
     }
 }
 
@@ -30,19 +33,24 @@ RISCVAsmPrinter::RISCVAsmPrinter(std::string filename, Module* unit, RISCVLoweri
 }
 void RISCVAsmPrinter::SetTextSegment(textSegment* _text) {text=_text;}
 dataSegment* &RISCVAsmPrinter::GetData(){return data;} 
-void RISCVAsmPrinter::printAsmGlobal() {
-    std::cout << "    .file  \"" << filename << "\"" << std::endl;
-    std::cout << "    .attribute arch, \"rv64i2p1_m2p0_a2p1_f2p2_d2p2_c2p0_zicsr2p0\"" << std::endl;
-    std::cout << "    .attribute unaligned_access, 0" << std::endl; 
-    std::cout << "    .attribute stack_align, 16" << std::endl;
-    std::cout << "    .text" << std::endl;
-    this->data->PrintDataSegment_Globval();
+void RISCVAsmPrinter::printAsmGlobal(AsmEmitter& out) {
+    out << "    .file  \"" << filename << "\"" << '\n';
+    out << "    .attribute arch, \"rv64i2p1_m2p0_a2p1_f2p2_d2p2_c2p0_zicsr2p0\"" << '\n';
+    out << "    .attribute unaligned_access, 0" << '\n'; 
+    out << "    .attribute stack_align, 16" << '\n';
+    out << "    .text" << '\n';
+    this->data->PrintDataSegment_Globval(out);
 }
 
-void RISCVAsmPrinter::printAsm() {
-    this->printAsmGlobal();
-    this->text->PrintTextSegment();
-    this->data->PrintDataSegment_Tempvar();
+void RISCVAsmPrinter::printAsm(AsmEmitter& out) {
+    this->printAsmGlobal(out);
+    this->text->PrintTextSegment(out);
+    this->data->PrintDataSegment_Tempvar(out);
+}
+void RISCVAsmPrinter::emitObject(RISCVObjectWriter& obj) {
+    this->data->EmitDataSegment_Globval(obj);
+    this->text->EmitTextSegment(obj);
+    this->data->EmitDataSegment_Tempvar(obj);
 }
 
 //textSegment
@@ -55,11 +63,32 @@ void textSegment::GenerateFuncList(RISCVLoweringContext& ctx) {
         function_list.push_back(funcSeg);
     }
 }
-void textSegment::PrintTextSegment() {
-    PrintSegmentType(TEXT, oldtype);
-    for (auto& functionSegment : function_list) {
-        functionSegment->PrintFuncSegment();
+void textSegment::PrintTextSegment(AsmEmitter& out) {
+    PrintSegmentType(out, TEXT, oldtype);
+    // 函数之间互不影响, 各自格式化进自己的缓冲再按顺序拼起来
+    std::vector<AsmEmitter> funcs(function_list.size(), AsmEmitter(0));
+    size_t threads = std::min<size_t>(std::thread::hardware_concurrency(), function_list.size());
+    if (threads <= 1) {
+        for (size_t i = 0; i < function_list.size(); i++)
+            function_list[i]->PrintFuncSegment(funcs[i]);
+    }
+    else {
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++)
+            workers.emplace_back([&]() {
+                for (size_t i = next++; i < function_list.size(); i = next++)
+                    function_list[i]->PrintFuncSegment(funcs[i]);
+            });
+        for (auto& worker : workers)
+            worker.join();
     }
+    for (auto& func : funcs)
+        out << func;
+}
+void textSegment::EmitTextSegment(RISCVObjectWriter& obj) {
+    for (auto& func : function_list)
+        func->EmitFuncSegment(obj);
 }
 
 //functionSegment
@@ -69,13 +98,16 @@ functionSegment::functionSegment(RISCVFunction* function)
     name = function->GetName();
     size = -1;
 }
-void functionSegment::PrintFuncSegment() {
-    std::cout << "    .align  " << align << std::endl;
-    std::cout << "    .globl  " << name << std::endl;
-    std::cout << "    .type  " << name << ", @" << ty << std::endl;
-    func->printfull();
+void functionSegment::PrintFuncSegment(AsmEmitter& out) {
+    out << "    .align  " << align << '\n';
+    out << "    .globl  " << name << '\n';
+    out << "    .type  " << name << ", @" << ty << '\n';
+    func->printfull(out);
     if(size == -1)
-        std::cout << "    .size " << name << ", " << ".-" << name << std::endl;
+        out << "    .size " << name << ", " << ".-" << name << '\n';
+}
+void functionSegment::EmitFuncSegment(RISCVObjectWriter& obj) {
+    obj.EmitFunction(func);
 }
 //dataSegment
 dataSegment::dataSegment(Module* module, RISCVLoweringContext& ctx) {
@@ -154,14 +186,24 @@ void dataSegment::Change_LoadConstFloat(RISCVMIR* inst, tempvar* tempfloat, myli
         }
     }
 }  
-void dataSegment::PrintDataSegment_Globval() {
+void dataSegment::PrintDataSegment_Globval(AsmEmitter& out) {
     for(auto& gvar : globlvar_list) {
-        gvar->PrintGloblvar();
+        gvar->PrintGloblvar(out);
     }
 }
-void dataSegment::PrintDataSegment_Tempvar() {
+void dataSegment::PrintDataSegment_Tempvar(AsmEmitter& out) {
     for(auto& gvar : tempvar_list) {
-        gvar->PrintTempvar();
+        gvar->PrintTempvar(out);
+    }
+}
+void dataSegment::EmitDataSegment_Globval(RISCVObjectWriter& obj) {
+    for(auto& gvar : globlvar_list) {
+        gvar->EmitGloblvar(obj);
+    }
+}
+void dataSegment::EmitDataSegment_Tempvar(RISCVObjectWriter& obj) {
+    for(auto& gvar : tempvar_list) {
+        gvar->EmitTempvar(obj);
     }
 }
 
@@ -207,174 +249,91 @@ void dataSegment::LegalizeGloablVar(RISCVLoweringContext& ctx) {
 }
 
 //globlvar
-globlvar::globlvar(Variable* data):RISCVGlobalObject(data->GetType(),data->GetName()){
+globlvar::globlvar(Variable* data):RISCVGlobalObject(data->GetType(),data->GetName()),readonly(data->usage==Variable::Constant){
     
     InnerDataType tp = (dynamic_cast<PointerType*>(data->GetType()))->GetSubType()->GetTypeEnum();
     if(tp == InnerDataType::IR_Value_INT || tp == InnerDataType::IR_Value_Float) {
         align = 2;
         size = 4;
-        if (data->GetInitializer()) {
-            // sec = "data";
-            if(tp == InnerDataType::IR_Value_INT) {
-                std::string num = data->GetInitializer()->GetName();
-                int init = std::stoi(num);
-                init_vector.push_back(init);
-            }
-            if(tp == InnerDataType::IR_Value_Float) {
-                ConstIRFloat* temp = dynamic_cast<ConstIRFloat*>(data->GetInitializer());
-                float init = temp->GetVal();
-                init_vector.push_back(init);
-            }
-        }
-        // else {
-        //     sec = "bss";
-        // }
+        if (data->GetInitializer())
+            push_init(data->GetInitializer(), 0);
     }
     else if (tp == InnerDataType::IR_ARRAY) {
         align = 3;
-        Type* basetype = dynamic_cast<HasSubType*>(data->GetType())->get_baseType();
-        if(Initializer* arry_init = dynamic_cast<Initializer*>(data->GetInitializer())) {
-            size = arry_init->GetType()->get_size();
-            int init_size = arry_init->size();
-            if (init_size == 0) {
-                // sec = "bss";
-            }
-            else {
-                // sec = "data";
-                int limi = dynamic_cast<ArrayType*>(arry_init->GetType())->GetNumEle();
-                for(int i=0;i<limi;i++){
-                    if(i < init_size){
-                        if(auto inits=dynamic_cast<Initializer*>((*arry_init)[i])) {
-                            //递归
-                            generate_array_init(inits, basetype);  
-                        }
-                        else {//Leaf 
-                            if(basetype->GetTypeEnum() == IR_Value_INT) {
-                                std::string num = (*arry_init)[i]->GetName();
-                                int init = std::stoi(num);
-                                init_vector.push_back(init);
-                            }
-                            else if (basetype->GetTypeEnum() == IR_Value_Float) {
-                                ConstIRFloat* temp = dynamic_cast<ConstIRFloat*>((*arry_init)[i]);
-                                float init = temp->GetVal();
-                                init_vector.push_back(init);
-                            }
-                        }
-                    }
-                    else {
-                        Type* temptp = dynamic_cast<ArrayType*>(arry_init->GetType())->GetSubType();
-                        size_t zeronum = temptp->get_size() / basetype->get_size();
-                        for(int i=0; i<zeronum; i++) {
-                            if(basetype->GetTypeEnum() == IR_Value_INT) {
-                                init_vector.push_back(static_cast<int>(0));
-                            }
-                            else if (basetype->GetTypeEnum() == IR_Value_Float) {
-                                init_vector.push_back(static_cast<float>(0));                        
-                            }
-                        }
-                    }
-                }
-            } 
-        }
-        else {
-            // undefined arr;
-            size = (dynamic_cast<PointerType*>(data->GetType()))->GetSubType()->get_size();
-            // sec = "bss";
-        }
+        size = (dynamic_cast<PointerType*>(data->GetType()))->GetSubType()->get_size();
+        if(Initializer* arry_init = dynamic_cast<Initializer*>(data->GetInitializer()))
+            generate_array_init(arry_init, 0);
     }
     else align = -1;//Error
 }
-void globlvar::generate_array_init(Initializer* arry_init, Type* basetype) {
-    int init_size = arry_init->size();
-    int limi = dynamic_cast<ArrayType*>(arry_init->GetType())->GetNumEle();
-    if (init_size == 0) {
-        auto zero_num=arry_init->GetType()->get_size()/basetype->get_size();
-        for(auto i=0;i<zero_num;i++){
-            if(basetype->GetTypeEnum()==IR_Value_INT)init_vector.push_back(static_cast<int>(0));
-            else init_vector.push_back(static_cast<float>(0));
-        }
+void globlvar::push_init(Value* val, size_t offset) {
+    if(auto num = dynamic_cast<ConstIRInt*>(val)) {
+        if(num->GetVal() != 0)
+            init_vector.emplace_back(offset, num->GetVal());
     }
-    else {
-        for(int i=0; i<limi; i++) {
-            if(i<init_size) {
-                if(auto inits=dynamic_cast<Initializer*>((*arry_init)[i]))
-                    generate_array_init(inits, basetype);
-                else {
-                        if(basetype->GetTypeEnum() == IR_Value_INT) {
-                            std::string num = (*arry_init)[i]->GetName();
-                            int init = std::stoi(num);
-                            init_vector.push_back(init);
-                        }
-                        else if (basetype->GetTypeEnum() == IR_Value_Float) {
-                            ConstIRFloat* temp = dynamic_cast<ConstIRFloat*>((*arry_init)[i]);
-                            float init = temp->GetVal();
-                            init_vector.push_back(init);
-                        }                    
-                }
-            }
-            else {
-                Type* temptp = dynamic_cast<ArrayType*>(arry_init->GetType())->GetSubType();
-                size_t zeronum = temptp->get_size() / basetype->get_size();
-                    for(int i=0; i<zeronum; i++) {
-                    if (basetype->GetTypeEnum() == IR_Value_INT) {
-                        init_vector.push_back(static_cast<int>(0));
-                    }
-                    else if (basetype->GetTypeEnum() == IR_Value_Float) {
-                        init_vector.push_back(static_cast<float>(0));   
-                    }
-                }
-            }
-        }
+    else if(auto num = dynamic_cast<ConstIRFloat*>(val)) {
+        // -0.0 不是全零的位模式, 要留着
+        FloatBits bits;
+        bits.floatValue = num->GetVal();
+        if(bits.intBits != 0)
+            init_vector.emplace_back(offset, num->GetVal());
     }
+    else assert(0 && "global initializer must be constant");
 }
-
-void globlvar::PrintGloblvar() {
-    if (init_vector.empty()) {
-        std::cout << "    .globl  " << this->GetName() << std::endl;
-        PrintSegmentType(BSS, oldtype);
-        std::cout << "    .align  " << align << std::endl;
-        std::cout << "    .type  " << this->GetName() << ", @" << ty << std::endl;
-        std::cout << "    .size  " << this->GetName() << ", " << size << std::endl;
-        std::cout << this->GetName() << ":" << std::endl;
-        std::cout << "    .zero  " << size << std::endl; 
+void globlvar::generate_array_init(Initializer* arry_init, size_t offset) {
+    // 没写出来的元素都是 0, 只看写出来的
+    size_t stride = dynamic_cast<ArrayType*>(arry_init->GetType())->GetSubType()->get_size();
+    for(int i=0; i<arry_init->size(); i++) {
+        if(auto inits=dynamic_cast<Initializer*>((*arry_init)[i]))
+            generate_array_init(inits, offset + i*stride);
+        else
+            push_init((*arry_init)[i], offset + i*stride);
     }
-    else {
-        std::cout << "    .globl  " << this->GetName() << std::endl;
-        PrintSegmentType(DATA, oldtype);
-        std::cout << "    .align  " << align << std::endl;
-        std::cout << "    .type  " << this->GetName() << ", @" << ty << std::endl;
-        std::cout << "    .size  " << this->GetName() << ", " << size << std::endl;
-        std::cout << this->GetName() << ":" << std::endl;
-        int zero_count=0;
-        for(auto& init : init_vector) {
-            bool is_zero = std::visit([](auto&& value){return value==0;}, init);
-            if(is_zero) {
-                zero_count+=4;
-            }
-            else {
-                if(zero_count!=0) {
-                    std::cout << "    .zero  " << zero_count << std::endl;
-                    zero_count = 0;
-                }
-    
-                if(std::holds_alternative<int>(init)) {
-                    std::cout << "    .word  " << std::get<int>(init) << std::endl;
-                }
-                else {
-                    //float type
-                    FloatBits bits;
-                    bits.floatValue = std::get<float>(init); 
-                    std::string binaryString = std::bitset<32>(bits.intBits).to_string();
-                    int decNum = binaryToDecimal(binaryString);
-                    std::cout << "    .word  " << decNum << std::endl;
-                }
-            }
-            if (&init == &init_vector.back() && is_zero) {
-                std::cout << "    .zero  " << zero_count << std::endl;
-            }
+}
+
+void globlvar::PrintGloblvar(AsmEmitter& out) {
+    out << "    .globl  " << this->GetName() << '\n';
+    if (init_vector.empty())
+        PrintSegmentType(out, BSS, oldtype);
+    else if (readonly)
+        PrintSegmentType(out, RODATA, oldtype);
+    else
+        PrintSegmentType(out, DATA, oldtype);
+    out << "    .align  " << align << '\n';
+    out << "    .type  " << this->GetName() << ", @" << ty << '\n';
+    out << "    .size  " << this->GetName() << ", " << size << '\n';
+    out << this->GetName() << ":" << '\n';
+    size_t pos = 0;
+    for(auto& [offset, init] : init_vector) {
+        if(offset > pos)
+            out << "    .zero  " << offset - pos << '\n';
+        if(std::holds_alternative<int>(init)) {
+            out << "    .word  " << std::get<int>(init) << '\n';
+        }
+        else {
+            //float type
+            FloatBits bits;
+            bits.floatValue = std::get<float>(init); 
+            std::string binaryString = std::bitset<32>(bits.intBits).to_string();
+            int decNum = binaryToDecimal(binaryString);
+            out << "    .word  " << decNum << '\n';
         }
+        pos = offset + 4;
+    }
+    if(pos < size)
+        out << "    .zero  " << size - pos << '\n';
+}
+void globlvar::EmitGloblvar(RISCVObjectWriter& obj) {
+    SegmentType seg = init_vector.empty() ? BSS : readonly ? RODATA : DATA;
+    size_t base = obj.DefineObject(this->GetName(), seg, 1 << align, size, true);
+    for(auto& [offset, init] : init_vector) {
+        FloatBits bits;
+        if(std::holds_alternative<int>(init))
+            bits.intBits = std::get<int>(init);
+        else
+            bits.floatValue = std::get<float>(init);
+        obj.WriteWord(seg, base + offset, bits.intBits);
     }
-
 }
 
 //tempvar
@@ -385,13 +344,20 @@ tempvar::tempvar(int num_lable, float init) :
 std::string tempvar::Getname() {
     return this->GetName();
 }
-void tempvar::PrintTempvar() {
-    PrintSegmentType(RODATA, oldtype);
-    std::cout << "    .align  " << align << std::endl;
-    std::cout << this->GetName() << ":" << std::endl;
+void tempvar::PrintTempvar(AsmEmitter& out) {
+    PrintSegmentType(out, RODATA, oldtype);
+    out << "    .align  " << align << '\n';
+    out << this->GetName() << ":" << '\n';
     FloatBits bits;
     bits.floatValue = init;
     std::string binaryString = std::bitset<32>(bits.intBits).to_string();
     int decNum = binaryToDecimal(binaryString);
-    std::cout << "    .word  " << decNum << std::endl;
+    out << "    .word  " << decNum << '\n';
+}
+void tempvar::EmitTempvar(RISCVObjectWriter& obj) {
+    // .LC 标号不导出
+    size_t base = obj.DefineObject(this->GetName(), RODATA, 1 << align, 4, false);
+    FloatBits bits;
+    bits.floatValue = init;
+    obj.WriteWord(RODATA, base, bits.intBits);
 }
@@ -21,8 +21,11 @@ RISCVMOperand* RISCVLoweringContext::Create(Value* val){
             return createVReg(RISCVTyper(inst->GetType()));
         }
     }
-    else if(auto bb=dynamic_cast<BasicBlock*>(val))
-        return RISCVBasicBlock::CreateRISCVBasicBlock();
+    else if(auto bb=dynamic_cast<BasicBlock*>(val)){
+        auto mbb=RISCVBasicBlock::CreateRISCVBasicBlock();
+        mbb->LoopDepth=bb->LoopDepth;
+        return mbb;
+    }
     else if(val->isConst()){
         // change bool const to int const
         if(auto boolval=val->as<ConstIRBoolean>()){
@@ -90,6 +93,8 @@ RISCVBasicBlock*& RISCVLoweringContext::GetCurBasicBlock() {return cur_mbb;}
 extern RISCVAsmPrinter* asmprinter;
 void RISCVLoweringContext::print(){
     /// @todo print global variables
+    AsmEmitter out;
     for(auto& mfunc:functions)
-        mfunc->printfull();
+        mfunc->printfull(out);
+    std::cout<<out.str();
 }
\ No newline at end of file
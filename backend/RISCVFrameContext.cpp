@@ -2,8 +2,8 @@
 std::string& NamedMOperand::GetName() {return name;}
 NamedMOperand::NamedMOperand(std::string _name,RISCVType _tp):RISCVMOperand(_tp),name(_name){}
 
-void NamedMOperand::print(){
-    std::cout<<name;
+void NamedMOperand::print(AsmEmitter& out){
+    out<<name;
 }
 
 RISCVObject::RISCVObject(Type* _tp,std::string _name):NamedMOperand(_name,riscv_ptr),tp(_tp){}
@@ -11,19 +11,19 @@ RISCVObject::RISCVObject(std::string _name):NamedMOperand(_name,riscv_ptr) {}
 RISCVGlobalObject::RISCVGlobalObject(Type* _tp,std::string _name):RISCVObject(_tp,_name){
     local=false;
 }
-void RISCVGlobalObject::print(){
+void RISCVGlobalObject::print(AsmEmitter& out){
     // std::cout<<"***";
     // tp->print();
     // std::cout<<"GlobalObject:";
-    NamedMOperand::print();
+    NamedMOperand::print(out);
     // std::cout<<"***\n";
-    std::cout<<"\n";
+    out<<"\n";
 }
 
 RISCVTempFloatObject::RISCVTempFloatObject(std::string _name):RISCVObject(FloatType::NewFloatTypeGet(), _name){
     local=true;
 }
-void RISCVTempFloatObject::print() {}
+void RISCVTempFloatObject::print(AsmEmitter& out) {}
 
 // RISCVFrameObject::RISCVFrameObject(Type* _tp,std::string _name):RISCVObject(_tp,_name){
 //     local=true;
@@ -65,11 +65,11 @@ RISCVType RISCVFrameObject::GetContextType() {return contextype;}
 void RISCVFrameObject::SetBeginAddOff(size_t add) {begin_addr_offsets = add;}
 void RISCVFrameObject::SetEndAddOff(size_t add) {end_addr_offsets = add;}
 StackRegister*& RISCVFrameObject::GetStackReg() {return reg;}
-void RISCVFrameObject::print(){
+void RISCVFrameObject::print(AsmEmitter& out){
     // std::cout<<"---";
     // std::cout<<"FrameObject";
     // std::cout<<"---";
-    reg->print();
+    reg->print(out);
 }
 
 BegAddrRegister::BegAddrRegister(RISCVFrameObject* _frameobj)
@@ -78,9 +78,9 @@ BegAddrRegister::BegAddrRegister(RISCVFrameObject* _frameobj)
 // BegAddrRegister::BegAddrRegister(size_t offset)
 //     : Register(riscv_i32), frameobj(nullptr) {}
 
-void BegAddrRegister::print() {
+void BegAddrRegister::print(AsmEmitter& out) {
     // should be the minus of the begin address
-  std::cout << "-" << frameobj->GetBeginAddOff();
+  out << "-" << frameobj->GetBeginAddOff();
 }
 
 
@@ -109,14 +109,14 @@ VirRegister* StackRegister::GetVreg() {
 Register*& StackRegister::GetReg() { return reg; }
 void StackRegister::SetPreg(PhyRegister* &_reg) { this->reg = _reg; }
 void StackRegister::SetReg(Register* _reg) { this->reg = _reg; }
-void StackRegister::print() {
+void StackRegister::print(AsmEmitter& out) {
   if(VirRegister* vreg = dynamic_cast<VirRegister*>(reg))  {
-    std::cout << offset << "(";
-    vreg->print();
-    std::cout << ")";
+    out << offset << "(";
+    vreg->print(out);
+    out << ")";
   } else if(PhyRegister* preg = dynamic_cast<PhyRegister*>(reg)) {
     PhyRegister::PhyReg regenum = preg->Getregenum();
-    std::cout << offset << "(" <<  magic_enum::enum_name(regenum) << ")";
+    out << offset << "(" <<  magic_enum::enum_name(regenum) << ")";
   }
   else assert(false&&"Error: StackRegister::print");
 }
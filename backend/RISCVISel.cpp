@@ -1,6 +1,7 @@
 #include "../include/backend/RISCVISel.hpp"
 #include "../include/backend/RISCVMIR.hpp"
 #include "../include/backend/RISCVFrameContext.hpp"
+#include "../include/ir/opt/tailrec.hpp"
 RISCVMIR* RISCVISel::Builder(RISCVMIR::RISCVISA _isa,User* inst){
     auto minst=new RISCVMIR(_isa);
     minst->SetDef(ctx.mapping(inst));
@@ -257,6 +258,8 @@ void RISCVISel::InstLowering(BinaryInst* inst){
         case BinaryInst::Op_Mul:
         {
             if(inst->GetType()==IntType::NewIntTypeGet()) {
+                if(LowerConstMul(inst, ctx))
+                    break;
                 if(ConstIRInt* constint = dynamic_cast<ConstIRInt*>(inst->GetOperand(1))) {
                     auto li = new RISCVMIR(RISCVMIR::li);
                     VirRegister* vreg = new VirRegister(riscv_i32);
@@ -280,6 +283,8 @@ void RISCVISel::InstLowering(BinaryInst* inst){
         case BinaryInst::Op_Div:
         {
             if(inst->GetType()==IntType::NewIntTypeGet()) {
+                if(LowerConstDiv(inst, ctx))
+                    break;
                 if(ConstIRInt* constint = dynamic_cast<ConstIRInt*>(inst->GetOperand(1))) {
                     auto li = new RISCVMIR(RISCVMIR::li);
                     VirRegister* vreg = new VirRegister(riscv_i32);
@@ -303,6 +308,8 @@ void RISCVISel::InstLowering(BinaryInst* inst){
         case BinaryInst::Op_Mod:
         {
             if(inst->GetType()==IntType::NewIntTypeGet()) {
+                if(LowerConstMod(inst, ctx))
+                    break;
                 if(ConstIRInt* constint = dynamic_cast<ConstIRInt*>(inst->GetOperand(1))) {
                     auto li = new RISCVMIR(RISCVMIR::li);
                     VirRegister* vreg = ctx.createVReg(riscv_i32);
@@ -353,13 +360,35 @@ void RISCVISel::InstLowering(BinaryInst* inst){
 void RISCVISel::InstLowering(GetElementPtrInst* inst){
     #define M(x) ctx.mapping(x)
     // cast it to multiple add and mul first 
-    /// @todo 循环不变量外提很重要了这里，之后会做一个循环不变量外提的优化
+    /// @note 循环不变的 GEP 已经由 IR 层的 LICM 提到 preheader 里了
     int limi=inst->Getuselist().size();
     auto baseptr=M(inst->GetOperand(0));
     auto hasSubtype=dynamic_cast<HasSubType*>(inst->GetOperand(0)->GetType());
     size_t offset=0;
     using PhyReg=PhyRegister::PhyReg;
     using ISA = RISCVMIR::RISCVISA;
+
+    // 下标全是常数且基址已经在寄存器里(比如 LSR 产生的指针 phi), 直接折成 offset(reg), 不用再拷一次基址
+    bool allconst=true;
+    for(int i=1;i<limi;i++)
+        allconst&=inst->GetOperand(i)->isConst();
+    VirRegister* basereg=dynamic_cast<VirRegister*>(baseptr);
+    int baseoff=0;
+    if(auto sreg=dynamic_cast<StackRegister*>(baseptr)){
+        if(sreg->GetParent()==nullptr){
+            basereg=sreg->GetVreg();
+            baseoff=sreg->GetOffset();
+        }
+    }
+    if(allconst&&basereg!=nullptr){
+        for(int i=1;i<limi;i++){
+            size_t size=hasSubtype->GetSubType()->get_size();
+            offset+=size*(size_t)inst->GetOperand(i)->as<ConstIRInt>()->GetVal();
+            hasSubtype=dynamic_cast<HasSubType*>(hasSubtype->GetSubType());
+        }
+        ctx.change_mapping(ctx.mapping(inst->GetDef()), new StackRegister(basereg, baseoff+(int)offset));
+        return;
+    }
     PhyRegister* s0 = PhyRegister::GetPhyReg(PhyReg::s0);
     // PhyRegister* t0 = PhyRegister::GetPhyReg(PhyReg::t0);
     VirRegister* vreg= new VirRegister(RISCVType::riscv_i32);
@@ -564,6 +593,8 @@ void RISCVISel::InstLowering(CallInst* inst){
     }
 
     ctx(call);
+    if(IsSiblingCall(inst, spillnodes))
+        ctx.GetCurFunction()->GetSiblingCalls().push_back(call);
 
     if(!inst->GetUserlist().is_empty()){
         // ctx(Builder_withoutDef(RISCVMIR::call, inst));
@@ -583,6 +614,25 @@ void RISCVISel::InstLowering(CallInst* inst){
     #undef M
 }
 
+bool RISCVISel::IsSiblingCall(CallInst* inst, std::vector<int>& spillnodes){
+    if(!spillnodes.empty())
+        return false;
+    mylist<BasicBlock,User>::iterator it(inst);
+    ++it;
+    if(it==inst->GetParent()->end())
+        return false;
+    auto ret=dynamic_cast<RetInst*>(*it);
+    if(ret==nullptr)
+        return false;
+    if(!ret->Getuselist().empty() && !ret->GetOperand(0)->isUndefVal() && ret->GetOperand(0)!=inst)
+        return false;
+    // 局部数组的地址传下去的话, 栈帧一释放被调函数就读到垃圾
+    for(int i=1; i<inst->Getuselist().size(); i++)
+        if(TailRecElim::PointsToFrame(inst->GetOperand(i)))
+            return false;
+    return true;
+}
+
 void RISCVISel::InstLowering(RetInst* inst){
     #define M(x) ctx.mapping(x)
     if(inst->Getuselist().empty() || inst->GetOperand(0)->isUndefVal()) {
@@ -669,7 +719,7 @@ RISCVISel::RISCVISel(RISCVLoweringContext& _ctx):ctx(_ctx){}
 void RISCVISel::condition_helper(BinaryInst* inst){
     assert(inst->GetType()==BoolType::NewBoolTypeGet());
     assert(inst->GetOperand(0)->GetType()==inst->GetOperand(1)->GetType());
-    assert(inst->GetOperand(0)->GetType()==BoolType::NewBoolTypeGet()||inst->GetOperand(0)->GetType()==IntType::NewIntTypeGet()||inst->GetOperand(1)->GetType()==FloatType::NewFloatTypeGet());
+    assert(inst->GetOperand(0)->GetType()==BoolType::NewBoolTypeGet()||inst->GetOperand(0)->GetType()==IntType::NewIntTypeGet()||inst->GetOperand(1)->GetType()==FloatType::NewFloatTypeGet()||inst->GetOperand(0)->GetTypeEnum()==IR_PTR);
     bool isint=(inst->GetOperand(0)->GetType()!=FloatType::NewFloatTypeGet());
     switch (inst->getopration())
     {
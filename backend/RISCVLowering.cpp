@@ -2,6 +2,10 @@
 #include "../include/backend/PhiElimination.hpp"
 #include "../include/backend/BuildInFunctionTransform.hpp"
 #include "../include/backend/PostRACalleeSavedLegalizer.hpp"
+#include "../include/backend/BranchFolding.hpp"
+#include "../include/backend/BlockPlacement.hpp"
+#include "../include/backend/SiblingCall.hpp"
+#include "../include/backend/RISCVObjectWriter.hpp"
 
 RISCVAsmPrinter* asmprinter=nullptr;
 void RISCVModuleLowering::LowerGlobalArgument(Module* m){
@@ -20,7 +24,17 @@ bool RISCVModuleLowering::run(Module* m){
         }
     }
 
-    asmprinter->printAsm();
+    if(object){
+        RISCVObjectWriter obj;
+        asmprinter->emitObject(obj);
+        if(!obj.WriteTo(output))
+            std::cerr<<"Cannot write "<<output<<'\n';
+        return false;
+    }
+    AsmEmitter out(1<<20);
+    asmprinter->printAsm(out);
+    if(!out.WriteTo(output))
+        std::cerr<<"Cannot write "<<output<<'\n';
     // ctx.print();
     return false;
 }
@@ -52,7 +66,16 @@ bool RISCVFunctionLowering::run(Function* m){
 
     // Register Allocation
     RegAllocImpl regalloc(mfunc, ctx);
-    regalloc.RunGCpass();
+    regalloc.run();
+
+    SiblingCall siblingcall;
+    siblingcall.run(mfunc);
+
+    // 分配完拷贝块里的 mv 大多合并掉了, 剩下的空跳转在这里清理
+    BranchFolding branchfolding;
+    branchfolding.run(mfunc);
+    BlockPlacement placement;
+    placement.run(mfunc);
 
     // Generate Frame of current Function
     // And generate the head and tail of frame here
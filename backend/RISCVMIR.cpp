@@ -28,35 +28,38 @@ void RISCVMIR::SetMopcode(RISCVISA isa) {
     this->opcode=isa;
 }
 
-void RISCVMIR::printfull(){
+void RISCVMIR::printfull(AsmEmitter& out){
     std::string name(magic_enum::enum_name(opcode));
     if (name.find('_') != std::string::npos) name.erase(0,1);
     size_t pos=0;
     while((pos=name.find('_'))!=std::string::npos) name.replace(pos, 1, ".");
     if(name=="ret") {
-        this->GetParent()->GetParent()->GetExit()->printfull();
-        std::cout<<"\t"<< name <<" \n";
+        this->GetParent()->GetParent()->GetExit()->printfull(out);
+        out<<"\t"<< name <<" \n";
         return;
     }
-    std::cout<<"\t"<< name <<" ";
-    if (name=="call") {
-        operands[0]->print();
+    if(name=="tail") {
+        this->GetParent()->GetParent()->GetExit()->printfull(out);
+    }
+    out<<"\t"<< name <<" ";
+    if (name=="call"||name=="tail") {
+        operands[0]->print(out);
     }
     else { 
         if(def!=nullptr) {
-            def->print();
-            if(operands.size()>0) std::cout << ", ";
+            def->print(out);
+            if(operands.size()>0) out << ", ";
         }
         
         for(int i=0;i<operands.size();i++){
-            operands[i]->print();
+            operands[i]->print(out);
             if(i!=operands.size()-1)
-                std::cout<<", ";
+                out<<", ";
         }
         if(name=="fcvt.w.s") {
-            std::cout<<", rtz";
+            out<<", rtz";
         }
-        std::cout <<'\n';
+        out <<'\n';
     } 
 }
 
@@ -157,23 +160,23 @@ RISCVFunction::RISCVFunction(Value* _func):RISCVGlobalObject(_func->GetType(),_f
 }
 
 
-void RISCVBasicBlock::printfull(){
+void RISCVBasicBlock::printfull(AsmEmitter& out){
     if(this->GetName()==".LBBexit") {}
     else {
-        NamedMOperand::print();
-        std::cout<<":\n";
+        NamedMOperand::print(out);
+        out<<":\n";
     }
     for(auto minst:*this)
-        minst->printfull();
+        minst->printfull(out);
 }
 
 /// @todo the entry bb, or prologue bb will be generated by RISCVFunction after RA, and will be named as entry?
-void RISCVFunction::printfull(){
+void RISCVFunction::printfull(AsmEmitter& out){
     
-    NamedMOperand::print();
-    std::cout<<":\n";
+    NamedMOperand::print(out);
+    out<<":\n";
     for(auto mbb:*this){
-        mbb->printfull();
+        mbb->printfull(out);
         // if(mbb!=this->back())
         //     std::cout<<"\n";
     }
@@ -181,17 +184,26 @@ void RISCVFunction::printfull(){
 
 uint64_t RISCVFunction::GetUsedPhyRegMask(){
     uint64_t flag=0u;
+    // 只被定值的寄存器和 %lo(name)(reg) 里的寄存器也算被使用过
+    auto mark=[&flag](RISCVMOperand* op){
+        if(op==nullptr)return;
+        PhyRegister* reg=nullptr;
+        if(auto sR=op->as<StackRegister>())
+            reg=sR->GetReg()->as<PhyRegister>();
+        else if(auto laR=op->as<LARegister>()){
+            if(laR->GetVreg()!=nullptr)
+                reg=laR->GetVreg()->as<PhyRegister>();
+        }
+        else
+            reg=op->as<PhyRegister>();
+        if(reg!=nullptr)
+            flag|=PhyRegMask::GetPhyRegMask(reg);
+    };
     for(auto bb:*this){
         for(auto inst:*bb){
-            for(int i=0;i<inst->GetOperandSize();i++){
-                PhyRegister* reg=nullptr;
-                if(auto sR=inst->GetOperand(i)->as<StackRegister>())
-                    reg=sR->GetReg()->as<PhyRegister>();
-                else
-                    reg=inst->GetOperand(i)->as<PhyRegister>();
-                if(reg!=nullptr)
-                    flag|=PhyRegMask::GetPhyRegMask(reg);
-            }
+            mark(inst->GetDef());
+            for(int i=0;i<inst->GetOperandSize();i++)
+                mark(inst->GetOperand(i));
         }
     }
     return flag;
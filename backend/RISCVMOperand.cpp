@@ -86,8 +86,8 @@ Imm *Imm::GetImm(ConstantData *_data) {
   return mapping[_data].get();
 }
 
-void Imm::print() {
+void Imm::print(AsmEmitter &out) {
   // data->GetType()->print();
   // std::cout<<" ";
-  data->print();
+  out << data->GetName();
 }
\ No newline at end of file
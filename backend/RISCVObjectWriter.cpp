@@ -0,0 +1,523 @@
+#include "../include/backend/RISCVObjectWriter.hpp"
+#include <cstdio>
+#include <cstring>
+using ISA = RISCVMIR::RISCVISA;
+
+namespace {
+/// @brief 一条编码好的机器指令, 块间跳转和符号引用在布局之后再填
+struct MCInst {
+    uint32_t bits;
+    // 块间跳转的目标
+    RISCVBasicBlock* target = nullptr;
+    // 条件跳转超出 B 型范围, 展开成反向条件跳转 + jal 两条
+    bool relaxed = false;
+    std::string symbol;
+    uint32_t reloc = R_RISCV_NONE;
+};
+
+uint32_t R(uint32_t funct7, uint32_t rs2, uint32_t rs1, uint32_t funct3, uint32_t rd, uint32_t opcode) {
+    return funct7 << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12 | rd << 7 | opcode;
+}
+uint32_t I(int32_t imm, uint32_t rs1, uint32_t funct3, uint32_t rd, uint32_t opcode) {
+    return (uint32_t)(imm & 0xfff) << 20 | rs1 << 15 | funct3 << 12 | rd << 7 | opcode;
+}
+uint32_t S(int32_t imm, uint32_t rs2, uint32_t rs1, uint32_t funct3, uint32_t opcode) {
+    return (uint32_t)(imm >> 5 & 0x7f) << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12 | (uint32_t)(imm & 0x1f) << 7 | opcode;
+}
+uint32_t B(int32_t imm, uint32_t rs2, uint32_t rs1, uint32_t funct3) {
+    return (uint32_t)(imm >> 12 & 1) << 31 | (uint32_t)(imm >> 5 & 0x3f) << 25 | rs2 << 20 | rs1 << 15 |
+           funct3 << 12 | (uint32_t)(imm >> 1 & 0xf) << 8 | (uint32_t)(imm >> 11 & 1) << 7 | 0x63;
+}
+uint32_t U(int32_t imm20, uint32_t rd, uint32_t opcode) {
+    return (uint32_t)(imm20 & 0xfffff) << 12 | rd << 7 | opcode;
+}
+uint32_t J(int32_t imm, uint32_t rd) {
+    return (uint32_t)(imm >> 20 & 1) << 31 | (uint32_t)(imm >> 1 & 0x3ff) << 21 | (uint32_t)(imm >> 11 & 1) << 20 |
+           (uint32_t)(imm >> 12 & 0xff) << 12 | rd << 7 | 0x6f;
+}
+
+const uint32_t RA = 1, T1 = 6;
+// 浮点运算不写舍入模式时汇编器用 dyn
+const uint32_t RM_DYN = 7, RM_RTZ = 1;
+
+uint32_t Reg(RISCVMOperand* op) {
+    auto preg = dynamic_cast<PhyRegister*>(op);
+    assert(preg != nullptr && "operand must be a physical register when emitting object");
+    int regenum = preg->Getregenum();
+    if (regenum >= PhyRegister::begin_float_reg)
+        return regenum - PhyRegister::begin_float_reg;
+    return regenum;
+}
+
+int32_t ImmVal(RISCVMOperand* op) {
+    if (auto imm = dynamic_cast<Imm*>(op)) {
+        if (auto num = dynamic_cast<ConstIRInt*>(imm->Getdata()))
+            return num->GetVal();
+        if (auto num = dynamic_cast<ConstIRBoolean*>(imm->Getdata()))
+            return num->GetVal();
+    }
+    if (auto beg = dynamic_cast<BegAddrRegister*>(op))
+        return -(int32_t)beg->GetFrameObj()->GetBeginAddOff();
+    assert(0 && "unsupported immediate operand");
+    return 0;
+}
+
+/// @brief 栈上对象打印的就是它的 StackRegister
+RISCVMOperand* Address(RISCVMOperand* op) {
+    if (auto fobj = dynamic_cast<RISCVFrameObject*>(op))
+        return fobj->GetStackReg();
+    return op;
+}
+
+/// @brief 去掉 @plt 之类的后缀, 剩下的才是符号名
+std::string SymbolName(const std::string& name) {
+    return name.substr(0, name.find('@'));
+}
+
+class Encoder {
+    std::vector<MCInst>& out;
+
+    void Emit(uint32_t bits, const std::string& symbol = "", uint32_t reloc = R_RISCV_NONE) {
+        MCInst inst;
+        inst.bits = bits;
+        inst.symbol = symbol;
+        inst.reloc = reloc;
+        out.push_back(inst);
+    }
+    /// @brief 第 i 个操作数作为 I 型立即数, %lo(sym) 的话留重定位
+    void EmitI(RISCVMOperand* op, uint32_t rs1, uint32_t funct3, uint32_t rd, uint32_t opcode) {
+        if (auto la = dynamic_cast<LARegister*>(op)) {
+            assert(la->regnum == LARegister::lo && la->GetVreg() == nullptr);
+            Emit(I(0, rs1, funct3, rd, opcode), la->GetName(), R_RISCV_LO12_I);
+        }
+        else
+            Emit(I(ImmVal(op), rs1, funct3, rd, opcode));
+    }
+    /// @brief offset(reg) 或者 %lo(sym)(reg) 形式的访存
+    void EmitLoad(RISCVMIR* mir, uint32_t funct3, uint32_t opcode) {
+        uint32_t rd = Reg(mir->GetDef());
+        RISCVMOperand* addr = Address(mir->GetOperand(0));
+        if (auto sreg = dynamic_cast<StackRegister*>(addr))
+            Emit(I(sreg->GetOffset(), Reg(sreg->GetReg()), funct3, rd, opcode));
+        else if (auto la = dynamic_cast<LARegister*>(addr))
+            Emit(I(0, Reg(la->GetVreg()), funct3, rd, opcode), la->GetName(), R_RISCV_LO12_I);
+        else
+            assert(0 && "unsupported load address");
+    }
+    void EmitStore(RISCVMIR* mir, uint32_t funct3, uint32_t opcode) {
+        uint32_t rs2 = Reg(mir->GetOperand(0));
+        RISCVMOperand* addr = Address(mir->GetOperand(1));
+        if (auto sreg = dynamic_cast<StackRegister*>(addr))
+            Emit(S(sreg->GetOffset(), rs2, Reg(sreg->GetReg()), funct3, opcode));
+        else if (auto la = dynamic_cast<LARegister*>(addr))
+            Emit(S(0, rs2, Reg(la->GetVreg()), funct3, opcode), la->GetName(), R_RISCV_LO12_S);
+        else
+            assert(0 && "unsupported store address");
+    }
+    void EmitBranch(RISCVBasicBlock* target, uint32_t rs1, uint32_t rs2, uint32_t funct3) {
+        MCInst inst;
+        inst.bits = B(0, rs2, rs1, funct3);
+        inst.target = target;
+        out.push_back(inst);
+    }
+    /// @brief 和汇编器一样: 12 位以内 addi, 否则 lui + addiw
+    void EmitLi(uint32_t rd, int32_t val) {
+        int32_t hi = (int32_t)(((int64_t)val + 0x800) >> 12);
+        int32_t lo = val - (int32_t)((uint32_t)hi << 12);
+        if (hi == 0) {
+            Emit(I(lo, 0, 0, rd, 0x13));
+            return;
+        }
+        Emit(U(hi, rd, 0x37));
+        if (lo != 0)
+            Emit(I(lo, rd, 0, rd, 0x1b));
+    }
+    void EmitCall(RISCVMOperand* callee, uint32_t link, uint32_t temp) {
+        auto func = dynamic_cast<NamedMOperand*>(callee);
+        assert(func != nullptr && "call target must be a symbol");
+        Emit(U(0, temp, 0x17), func->GetName(), R_RISCV_CALL_PLT);
+        Emit(I(0, temp, 0, link, 0x67));
+    }
+
+    public:
+    Encoder(std::vector<MCInst>& out) : out(out) {}
+    void Encode(RISCVMIR* mir) {
+        auto rd = [&]() { return Reg(mir->GetDef()); };
+        auto rs = [&](int i) { return Reg(mir->GetOperand(i)); };
+        auto opR = [&](uint32_t funct7, uint32_t funct3, uint32_t opcode) {
+            Emit(R(funct7, rs(1), rs(0), funct3, rd(), opcode));
+        };
+        auto opI = [&](uint32_t funct3, uint32_t opcode) {
+            EmitI(mir->GetOperand(1), rs(0), funct3, rd(), opcode);
+        };
+        auto shiftI = [&](uint32_t funct3, uint32_t opcode, int32_t high) {
+            Emit(I(high | ImmVal(mir->GetOperand(1)), rs(0), funct3, rd(), opcode));
+        };
+        auto opF = [&](uint32_t funct7, uint32_t funct3) {
+            Emit(R(funct7, rs(1), rs(0), funct3, rd(), 0x53));
+        };
+        auto cvtF = [&](uint32_t funct7, uint32_t rs2, uint32_t rm) {
+            Emit(R(funct7, rs2, rs(0), rm, rd(), 0x53));
+        };
+        auto fma = [&](uint32_t opcode) {
+            Emit(rs(2) << 27 | R(0, rs(1), rs(0), RM_DYN, rd(), opcode));
+        };
+        auto block = [&](int i) {
+            auto target = dynamic_cast<RISCVBasicBlock*>(mir->GetOperand(i));
+            assert(target != nullptr && "branch target must be a block");
+            return target;
+        };
+        switch (mir->GetOpcode()) {
+        case ISA::_sll: opR(0, 1, 0x33); break;
+        case ISA::_srl: opR(0, 5, 0x33); break;
+        case ISA::_sra: opR(0x20, 5, 0x33); break;
+        case ISA::_sllw: opR(0, 1, 0x3b); break;
+        case ISA::_srlw: opR(0, 5, 0x3b); break;
+        case ISA::_sraw: opR(0x20, 5, 0x3b); break;
+        case ISA::_slli: shiftI(1, 0x13, 0); break;
+        case ISA::_srli: shiftI(5, 0x13, 0); break;
+        case ISA::_srai: shiftI(5, 0x13, 0x400); break;
+        case ISA::_slliw: shiftI(1, 0x1b, 0); break;
+        case ISA::_srliw: shiftI(5, 0x1b, 0); break;
+        case ISA::_sraiw: shiftI(5, 0x1b, 0x400); break;
+
+        case ISA::_add: opR(0, 0, 0x33); break;
+        case ISA::_sub: opR(0x20, 0, 0x33); break;
+        case ISA::_addw: opR(0, 0, 0x3b); break;
+        case ISA::_subw: opR(0x20, 0, 0x3b); break;
+        case ISA::_addi: opI(0, 0x13); break;
+        case ISA::_addiw: opI(0, 0x1b); break;
+        case ISA::_lui: {
+            auto la = dynamic_cast<LARegister*>(mir->GetOperand(0));
+            if (la != nullptr) {
+                assert(la->regnum == LARegister::hi);
+                Emit(U(0, rd(), 0x37), la->GetName(), R_RISCV_HI20);
+            }
+            else
+                Emit(U(ImmVal(mir->GetOperand(0)), rd(), 0x37));
+            break;
+        }
+        case ISA::_auipc: Emit(U(ImmVal(mir->GetOperand(0)), rd(), 0x17)); break;
+        case ISA::_mul: opR(1, 0, 0x33); break;
+        case ISA::_mulh: opR(1, 1, 0x33); break;
+        case ISA::_mulhsu: opR(1, 2, 0x33); break;
+        case ISA::_mulhu: opR(1, 3, 0x33); break;
+        case ISA::_mulw: opR(1, 0, 0x3b); break;
+        case ISA::_div: opR(1, 4, 0x33); break;
+        case ISA::_divu: opR(1, 5, 0x33); break;
+        case ISA::_divw: opR(1, 4, 0x3b); break;
+        case ISA::_rem: opR(1, 6, 0x33); break;
+        case ISA::_remu: opR(1, 7, 0x33); break;
+        case ISA::_remw: opR(1, 6, 0x3b); break;
+        case ISA::_remuw: opR(1, 7, 0x3b); break;
+
+        case ISA::_xor: opR(0, 4, 0x33); break;
+        case ISA::_or: opR(0, 6, 0x33); break;
+        case ISA::_and: opR(0, 7, 0x33); break;
+        case ISA::_xori: opI(4, 0x13); break;
+        case ISA::_ori: opI(6, 0x13); break;
+        case ISA::_andi: opI(7, 0x13); break;
+
+        case ISA::_seqz: Emit(I(1, rs(0), 3, rd(), 0x13)); break;
+        case ISA::_snez: Emit(R(0, rs(0), 0, 3, rd(), 0x33)); break;
+        case ISA::_slt: opR(0, 2, 0x33); break;
+        case ISA::_sltu: opR(0, 3, 0x33); break;
+        case ISA::_slti: opI(2, 0x13); break;
+        case ISA::_sltiu: opI(3, 0x13); break;
+
+        case ISA::_j: {
+            MCInst inst;
+            inst.bits = J(0, 0);
+            inst.target = block(0);
+            out.push_back(inst);
+            break;
+        }
+        case ISA::_beq: EmitBranch(block(2), rs(0), rs(1), 0); break;
+        case ISA::_bne: EmitBranch(block(2), rs(0), rs(1), 1); break;
+        case ISA::_blt: EmitBranch(block(2), rs(0), rs(1), 4); break;
+        case ISA::_bge: EmitBranch(block(2), rs(0), rs(1), 5); break;
+        case ISA::_bltu: EmitBranch(block(2), rs(0), rs(1), 6); break;
+        case ISA::_bgeu: EmitBranch(block(2), rs(0), rs(1), 7); break;
+        // ble/bgt 是交换操作数的 bge/blt
+        case ISA::_ble: EmitBranch(block(2), rs(1), rs(0), 5); break;
+        case ISA::_bgt: EmitBranch(block(2), rs(1), rs(0), 4); break;
+
+        case ISA::_lb: EmitLoad(mir, 0, 0x03); break;
+        case ISA::_lh: EmitLoad(mir, 1, 0x03); break;
+        case ISA::_lw: EmitLoad(mir, 2, 0x03); break;
+        case ISA::_ld: EmitLoad(mir, 3, 0x03); break;
+        case ISA::_lbu: EmitLoad(mir, 4, 0x03); break;
+        case ISA::_lhu: EmitLoad(mir, 5, 0x03); break;
+        case ISA::_sb: EmitStore(mir, 0, 0x23); break;
+        case ISA::_sh: EmitStore(mir, 1, 0x23); break;
+        case ISA::_sw: EmitStore(mir, 2, 0x23); break;
+        case ISA::_sd: EmitStore(mir, 3, 0x23); break;
+        case ISA::_flw: EmitLoad(mir, 2, 0x07); break;
+        case ISA::_fld: EmitLoad(mir, 3, 0x07); break;
+        case ISA::_fsw: EmitStore(mir, 2, 0x27); break;
+        case ISA::_fsd: EmitStore(mir, 3, 0x27); break;
+
+        case ISA::_fmv_w_x: cvtF(0x78, 0, 0); break;
+        case ISA::_fmv_x_w: cvtF(0x70, 0, 0); break;
+        case ISA::_fmv_s: Emit(R(0x10, rs(0), rs(0), 0, rd(), 0x53)); break;
+        case ISA::_fcvt_s_w: cvtF(0x68, 0, RM_DYN); break;
+        case ISA::_fcvt_s_wu: cvtF(0x68, 1, RM_DYN); break;
+        // 打印时 fcvt.w.s 固定带 rtz
+        case ISA::_fcvt_w_s: cvtF(0x60, 0, RM_RTZ); break;
+        case ISA::_fcvt_wu_s: cvtF(0x60, 1, RM_DYN); break;
+
+        case ISA::_fadd_s: opF(0x00, RM_DYN); break;
+        case ISA::_fsub_s: opF(0x04, RM_DYN); break;
+        case ISA::_fmul_s: opF(0x08, RM_DYN); break;
+        case ISA::_fdiv_s: opF(0x0c, RM_DYN); break;
+        case ISA::_fsqrt_s: cvtF(0x2c, 0, RM_DYN); break;
+        case ISA::_fmadd_s: fma(0x43); break;
+        case ISA::_fmsub_s: fma(0x47); break;
+        case ISA::_fnmsub_s: fma(0x4b); break;
+        case ISA::_fnmadd_s: fma(0x4f); break;
+        case ISA::_fsgnj_s: opF(0x10, 0); break;
+        case ISA::_fsgnjn_s: opF(0x10, 1); break;
+        case ISA::_fsgnjx_s: opF(0x10, 2); break;
+        case ISA::_fmin_s: opF(0x14, 0); break;
+        case ISA::_fmax_s: opF(0x14, 1); break;
+        case ISA::_feq_s: opF(0x50, 2); break;
+        case ISA::_flt_s: opF(0x50, 1); break;
+        case ISA::_fle_s: opF(0x50, 0); break;
+        // fgt/fge 是交换操作数的 flt/fle
+        case ISA::_fgt_s: Emit(R(0x50, rs(0), rs(1), 1, rd(), 0x53)); break;
+        case ISA::_fge_s: Emit(R(0x50, rs(0), rs(1), 0, rd(), 0x53)); break;
+
+        case ISA::mv: Emit(I(0, rs(0), 0, rd(), 0x13)); break;
+        case ISA::li: EmitLi(rd(), ImmVal(mir->GetOperand(0))); break;
+        case ISA::call: EmitCall(mir->GetOperand(0), RA, RA); break;
+        case ISA::tail: EmitCall(mir->GetOperand(0), 0, T1); break;
+        case ISA::ret: Emit(I(0, RA, 0, 0, 0x67)); break;
+        default:
+            std::cerr << "Cannot encode " << magic_enum::enum_name(mir->GetOpcode()) << '\n';
+            assert(0);
+        }
+    }
+};
+}
+
+RISCVObjectWriter::Section& RISCVObjectWriter::GetSection(SegmentType seg) {
+    switch (seg) {
+    case TEXT: return text;
+    case DATA: return data;
+    case BSS: return bss;
+    default: return rodata;
+    }
+}
+
+RISCVObjectWriter::Symbol& RISCVObjectWriter::GetSymbol(const std::string& name) {
+    auto it = symindex.find(name);
+    if (it != symindex.end())
+        return symbols[it->second];
+    symindex[name] = symbols.size();
+    symbols.push_back(Symbol{name, TEXT, false, true, STT_NOTYPE});
+    return symbols.back();
+}
+
+void RISCVObjectWriter::EmitFunction(RISCVFunction* func) {
+    std::vector<MCInst> insts;
+    std::map<RISCVBasicBlock*, size_t> label;
+    Encoder encoder(insts);
+    for (auto block : *func) {
+        label[block] = insts.size();
+        for (auto mir : *block) {
+            // 和打印时一样, 出口块的内容展开在每个 ret/tail 前面
+            if (mir->GetOpcode() == ISA::ret || mir->GetOpcode() == ISA::tail)
+                for (auto exit : *func->GetExit())
+                    encoder.Encode(exit);
+            encoder.Encode(mir);
+        }
+    }
+    // 先都按短跳转排, 超出范围的展开之后后面的偏移会变, 一直排到不再变化
+    std::vector<size_t> offset(insts.size() + 1);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < insts.size(); i++)
+            offset[i + 1] = offset[i] + (insts[i].relaxed ? 8 : 4);
+        for (size_t i = 0; i < insts.size(); i++) {
+            auto& inst = insts[i];
+            if (inst.target == nullptr || inst.relaxed || (inst.bits & 0x7f) != 0x63)
+                continue;
+            int64_t disp = (int64_t)offset[label[inst.target]] - (int64_t)offset[i];
+            if (disp < -4096 || disp > 4094)
+                inst.relaxed = changed = true;
+        }
+    }
+    size_t base = text.bytes.size();
+    for (size_t i = 0; i < insts.size(); i++) {
+        auto& inst = insts[i];
+        std::vector<uint32_t> words;
+        if (inst.target != nullptr) {
+            int64_t disp = (int64_t)offset[label[inst.target]] - (int64_t)offset[i];
+            if ((inst.bits & 0x7f) == 0x6f) {
+                assert(disp >= -(1 << 20) && disp < (1 << 20) && "jump out of range");
+                words.push_back(inst.bits | J(disp, 0));
+            }
+            else if (!inst.relaxed)
+                words.push_back(inst.bits | B(disp, 0, 0, 0));
+            else {
+                // 条件取反跳过下一条, 下一条 jal 跳到真正的目标
+                words.push_back((inst.bits ^ (1 << 12)) | B(8, 0, 0, 0));
+                assert(disp - 4 >= -(1 << 20) && disp - 4 < (1 << 20) && "jump out of range");
+                words.push_back(J(disp - 4, 0));
+            }
+        }
+        else
+            words.push_back(inst.bits);
+        if (inst.reloc != R_RISCV_NONE)
+            relocs.push_back(Reloc{base + offset[i], SymbolName(inst.symbol), inst.reloc});
+        for (auto word : words)
+            for (int b = 0; b < 4; b++)
+                text.bytes.push_back((char)(word >> (8 * b)));
+    }
+    text.size = text.bytes.size();
+    Symbol& sym = GetSymbol(func->GetName());
+    sym.seg = TEXT;
+    sym.defined = true;
+    sym.type = STT_FUNC;
+    sym.value = base;
+    sym.size = text.size - base;
+}
+
+size_t RISCVObjectWriter::DefineObject(const std::string& name, SegmentType seg, size_t align, size_t size, bool global) {
+    Section& sec = GetSection(seg);
+    sec.align = std::max(sec.align, align);
+    size_t offset = (sec.size + align - 1) / align * align;
+    sec.size = offset + size;
+    if (seg != BSS)
+        sec.bytes.resize(sec.size, '\0');
+    Symbol& sym = GetSymbol(name);
+    sym.seg = seg;
+    sym.defined = true;
+    sym.global = global;
+    sym.type = STT_OBJECT;
+    sym.value = offset;
+    sym.size = size;
+    return offset;
+}
+
+void RISCVObjectWriter::WriteWord(SegmentType seg, size_t offset, uint32_t word) {
+    Section& sec = GetSection(seg);
+    for (int b = 0; b < 4; b++)
+        sec.bytes[offset + b] = (char)(word >> (8 * b));
+}
+
+bool RISCVObjectWriter::WriteTo(const std::string& path) {
+    enum { NUL, TEXT_, RELA, DATA_, BSS_, RODATA_, NOTE, SYMTAB, STRTAB, SHSTRTAB, NUM };
+    auto shndx = [&](SegmentType seg) -> uint16_t {
+        switch (seg) {
+        case TEXT: return TEXT_;
+        case DATA: return DATA_;
+        case BSS: return BSS_;
+        default: return RODATA_;
+        }
+    };
+    // 被引用但没定义的是外部符号
+    for (auto& reloc : relocs)
+        GetSymbol(reloc.symbol);
+    // 局部符号必须排在全局符号前面
+    std::vector<size_t> order;
+    for (size_t i = 0; i < symbols.size(); i++)
+        if (!symbols[i].global)
+            order.push_back(i);
+    size_t first_global = order.size() + 1;
+    for (size_t i = 0; i < symbols.size(); i++)
+        if (symbols[i].global)
+            order.push_back(i);
+    std::string strtab(1, '\0');
+    std::string symtab(sizeof(Elf64_Sym), '\0');
+    std::vector<size_t> final_index(symbols.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        Symbol& sym = symbols[order[i]];
+        final_index[order[i]] = i + 1;
+        Elf64_Sym esym{};
+        esym.st_name = strtab.size();
+        strtab += sym.name;
+        strtab.push_back('\0');
+        esym.st_info = ELF64_ST_INFO(sym.global ? STB_GLOBAL : STB_LOCAL, sym.type);
+        esym.st_shndx = sym.defined ? shndx(sym.seg) : SHN_UNDEF;
+        esym.st_value = sym.value;
+        esym.st_size = sym.size;
+        symtab.append((const char*)&esym, sizeof(esym));
+    }
+    std::string rela;
+    for (auto& reloc : relocs) {
+        Elf64_Rela erela{};
+        erela.r_offset = reloc.offset;
+        erela.r_info = ELF64_R_INFO(final_index[symindex[reloc.symbol]], reloc.type);
+        erela.r_addend = 0;
+        rela.append((const char*)&erela, sizeof(erela));
+    }
+
+    std::string shstrtab(1, '\0');
+    std::vector<Elf64_Shdr> headers(NUM);
+    std::vector<const std::string*> contents(NUM, nullptr);
+    auto section = [&](int idx, const std::string& name, uint32_t type, uint64_t flags, size_t align,
+                       const std::string* content, size_t size) {
+        Elf64_Shdr& shdr = headers[idx];
+        shdr.sh_name = shstrtab.size();
+        shstrtab += name;
+        shstrtab.push_back('\0');
+        shdr.sh_type = type;
+        shdr.sh_flags = flags;
+        shdr.sh_addralign = align;
+        shdr.sh_size = size;
+        contents[idx] = content;
+    };
+    section(TEXT_, text.name, text.type, text.flags, text.align, &text.bytes, text.size);
+    section(RELA, ".rela.text", SHT_RELA, SHF_INFO_LINK, 8, &rela, rela.size());
+    headers[RELA].sh_link = SYMTAB;
+    headers[RELA].sh_info = TEXT_;
+    headers[RELA].sh_entsize = sizeof(Elf64_Rela);
+    section(DATA_, data.name, data.type, data.flags, data.align, &data.bytes, data.size);
+    section(BSS_, bss.name, bss.type, bss.flags, bss.align, nullptr, bss.size);
+    section(RODATA_, rodata.name, rodata.type, rodata.flags, rodata.align, &rodata.bytes, rodata.size);
+    // 标明不需要可执行栈
+    section(NOTE, ".note.GNU-stack", SHT_PROGBITS, 0, 1, nullptr, 0);
+    section(SYMTAB, ".symtab", SHT_SYMTAB, 0, 8, &symtab, symtab.size());
+    headers[SYMTAB].sh_link = STRTAB;
+    headers[SYMTAB].sh_info = first_global;
+    headers[SYMTAB].sh_entsize = sizeof(Elf64_Sym);
+    section(STRTAB, ".strtab", SHT_STRTAB, 0, 1, &strtab, strtab.size());
+    section(SHSTRTAB, ".shstrtab", SHT_STRTAB, 0, 1, &shstrtab, 0);
+    headers[SHSTRTAB].sh_size = shstrtab.size();
+
+    std::string file(sizeof(Elf64_Ehdr), '\0');
+    for (int i = 1; i < NUM; i++) {
+        size_t align = std::max<size_t>(headers[i].sh_addralign, 1);
+        file.resize((file.size() + align - 1) / align * align, '\0');
+        headers[i].sh_offset = file.size();
+        if (contents[i] != nullptr)
+            file += *contents[i];
+    }
+    file.resize((file.size() + 7) / 8 * 8, '\0');
+    Elf64_Ehdr ehdr{};
+    memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_ident[EI_OSABI] = ELFOSABI_NONE;
+    ehdr.e_type = ET_REL;
+    ehdr.e_machine = EM_RISCV;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_shoff = file.size();
+    ehdr.e_flags = EF_RISCV_FLOAT_ABI_DOUBLE;
+    ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+    ehdr.e_shentsize = sizeof(Elf64_Shdr);
+    ehdr.e_shnum = NUM;
+    ehdr.e_shstrndx = SHSTRTAB;
+    memcpy(&file[0], &ehdr, sizeof(ehdr));
+    for (auto& shdr : headers)
+        file.append((const char*)&shdr, sizeof(shdr));
+
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr)
+        return false;
+    bool ok = fwrite(file.data(), 1, file.size(), fp) == file.size();
+    return fclose(fp) == 0 && ok;
+}
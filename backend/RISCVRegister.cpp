@@ -55,7 +55,7 @@ void PhyRegMask::visit(uint64_t flag, std::function<void(uint64_t)> func) {
   }
 }
 
-void PhyRegister::print() { std::cout << magic_enum::enum_name(regenum); }
+void PhyRegister::print(AsmEmitter &out) { out << magic_enum::enum_name(regenum); }
 
 std::string PhyRegister::GetName() {
   auto x= magic_enum::enum_name(regenum);
@@ -65,8 +65,8 @@ std::string PhyRegister::GetName() {
 std::string VirRegister::GetName() {
     return "."+std::to_string(counter);
 }
-void VirRegister::print(){
-    std::cout<<"%"<<counter;
+void VirRegister::print(AsmEmitter& out){
+    out<<"%"<<counter;
 }
 // std::string VirRegister::GetName() {
 //   std::ostringstream oss;
@@ -84,14 +84,14 @@ LARegister::LARegister(RISCVType _type, std::string _name, VirRegister *_vreg)
 
 Register*& LARegister::GetVreg() { return vreg; }
 void LARegister::SetReg(PhyRegister* &_reg) { vreg = _reg; }
-void LARegister::print() {
+void LARegister::print(AsmEmitter &out) {
   // todo
-  std::cout << "%" << magic_enum::enum_name(regnum);
-  std::cout << "(" << rname << ")";
+  out << "%" << magic_enum::enum_name(regnum);
+  out << "(" << rname << ")";
   if (vreg != nullptr) {
-    std::cout << "(";
-    vreg->print();
-    std::cout << ")";
+    out << "(";
+    vreg->print(out);
+    out << ")";
     // std::cout << ")" << std::endl;
   }
 }
@@ -2,7 +2,18 @@
 
 RISCVMIR* RISCVTrival::CopyFrom(VirRegister* dst,RISCVMOperand* src){
     RISCVMIR* copyinst = nullptr;
-    if(dst->GetType()==RISCVType::riscv_i32 && src->GetType()==RISCVType::riscv_i32) {
+    auto isint=[](RISCVType tp){return tp==RISCVType::riscv_i32||tp==RISCVType::riscv_ptr;};
+    // GEP 的结果是 offset(reg) 的形式, 拷贝的时候直接把地址算出来
+    if(auto sreg=dynamic_cast<StackRegister*>(src)) {
+        if(sreg->GetParent()==nullptr) {
+            copyinst=new RISCVMIR(RISCVMIR::_addi);
+            copyinst->SetDef(dst);
+            copyinst->AddOperand(sreg->GetReg());
+            copyinst->AddOperand(Imm::GetImm(ConstIRInt::GetNewConstant(sreg->GetOffset())));
+            return copyinst;
+        }
+    }
+    if(isint(dst->GetType()) && isint(src->GetType())) {
         copyinst=new RISCVMIR(RISCVMIR::mv);
     }
     else if(dst->GetType()==RISCVType::riscv_float32 && src->GetType()==RISCVType::riscv_float32) {
@@ -1,10 +1,44 @@
 #include "../include/backend/RegAlloc.hpp"
 #include "../include/backend/LegalizePass.hpp"
+#include "../include/backend/RISCVFrameContext.hpp"
 void spill_reg(Operand vreg);
 void get_frameObj(Operand vreg);
 
+bool isRematerializable(RISCVMIR* def){
+    // li .1 imm
+    if(def->GetOpcode()==RISCVMIR::li)
+        return def->GetOperandSize()==1&&dynamic_cast<Imm*>(def->GetOperand(0));
+    // addi .1 s0 beginaddregister
+    if(def->GetOpcode()==RISCVMIR::_addi&&def->GetOperandSize()==2)
+        return def->GetOperand(0)==PhyRegister::GetPhyReg(PhyRegister::PhyReg::s0)
+            &&dynamic_cast<BegAddrRegister*>(def->GetOperand(1));
+    return false;
+}
+
+RISCVMIR* Rematerialize(RISCVMIR* def,VirRegister* temp){
+    RISCVMIR* mir=new RISCVMIR(def->GetOpcode());
+    mir->SetDef(temp);
+    for(int i=0;i<def->GetOperandSize();i++)
+        mir->AddOperand(def->GetOperand(i));
+    return mir;
+}
+
+RegAllocImpl::Allocator RegAllocImpl::allocator=RegAllocImpl::GraphColoring;
+
+void RegAllocImpl::run(){
+    if(allocator==LinearScanning)
+        RunLSpass();
+    else
+        RunGCpass();
+}
+
 void RegAllocImpl::RunGCpass(){
     gc=new GraphColor(m_func, ctx);
     gc->RunOnFunc();
     delete gc;
-}
\ No newline at end of file
+}
+
+void RegAllocImpl::RunLSpass(){
+    LinearScan ls(m_func);
+    ls.RunOnFunc();
+}
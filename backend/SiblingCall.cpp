@@ -0,0 +1,47 @@
+#include "../include/backend/SiblingCall.hpp"
+#include <set>
+
+bool SiblingCall::run(RISCVFunction* func){
+    bool modified=false;
+    for(auto call:func->GetSiblingCalls())
+        modified|=Rewrite(call);
+    func->GetSiblingCalls().clear();
+    return modified;
+}
+
+/// @brief 从 call 往后跟踪哪些寄存器里还是返回值
+/// @note 分配之后 ret 的操作数已经换成物理寄存器, 看不出返回的是 a0 还是 fa0, 两个都不许被改
+bool SiblingCall::Rewrite(RISCVMIR* call){
+    auto block=call->GetParent();
+    if(block==nullptr)
+        return false;
+    std::set<RISCVMOperand*> holders{PhyRegister::GetPhyReg(PhyRegister::a0),PhyRegister::GetPhyReg(PhyRegister::fa0)};
+    std::vector<RISCVMIR*> moves;
+    mylist<RISCVBasicBlock,RISCVMIR>::iterator it(call);
+    for(++it;it!=block->end();++it){
+        auto minst=*it;
+        auto opcode=minst->GetOpcode();
+        if(opcode==RISCVMIR::ret){
+            if(minst!=block->back())
+                return false;
+            for(auto move:moves)
+                delete move;
+            delete minst;
+            call->SetMopcode(RISCVMIR::tail);
+            return true;
+        }
+        if(opcode!=RISCVMIR::mv&&opcode!=RISCVMIR::_fmv_s)
+            return false;
+        if(minst->GetOperandSize()!=1)
+            return false;
+        auto def=minst->GetDef(),src=minst->GetOperand(0);
+        if(holders.find(src)!=holders.end())
+            holders.insert(def);
+        else
+            holders.erase(def);
+        if(holders.find(PhyRegister::GetPhyReg(PhyRegister::a0))==holders.end()||holders.find(PhyRegister::GetPhyReg(PhyRegister::fa0))==holders.end())
+            return false;
+        moves.push_back(minst);
+    }
+    return false;
+}
@@ -0,0 +1,137 @@
+#include "../include/backend/RISCVFrameContext.hpp"
+#include "../include/backend/RISCVMIR.hpp"
+#include "../include/backend/RISCVMOperand.hpp"
+#include "../include/backend/RISCVRegister.hpp"
+#include "../include/backend/RISCVType.hpp"
+#include "../include/backend/RegAlloc.hpp"
+using OpType = RISCVMIR::RISCVISA;
+
+StackRegister *SpillRewriter::GetSpillSlot(VirRegister *vreg) {
+  if (origin.count(vreg))
+    return GetSpillSlot(origin[vreg]);
+  if (slots.find(vreg) == slots.end())
+    slots[vreg] = m_func->GetFrame()->spill(vreg);
+  return slots[vreg];
+}
+
+RISCVMIR *SpillRewriter::CreateLoad(VirRegister *vreg, VirRegister *temp) {
+  RISCVMIR *ld = nullptr;
+  if (vreg->GetType() == RISCVType::riscv_float32)
+    ld = new RISCVMIR(OpType::_flw);
+  else
+    ld = new RISCVMIR(OpType::_ld);
+  ld->SetDef(temp);
+  ld->AddOperand(GetSpillSlot(vreg));
+  return ld;
+}
+
+RISCVMIR *SpillRewriter::CreateStore(VirRegister *vreg, VirRegister *temp) {
+  RISCVMIR *sd = nullptr;
+  if (vreg->GetType() == RISCVType::riscv_float32)
+    sd = new RISCVMIR(OpType::_fsw);
+  else
+    sd = new RISCVMIR(OpType::_sd);
+  sd->AddOperand(temp);
+  sd->AddOperand(GetSpillSlot(vreg));
+  return sd;
+}
+
+void SpillRewriter::Rewrite(
+    const std::vector<RISCVBasicBlock *> &blocks,
+    const std::unordered_set<VirRegister *> &spilled,
+    std::unordered_map<MOperand, RISCVMIR *> &remat,
+    std::unordered_set<VirRegister *> &temps,
+    std::unordered_set<MOperand> &unspillable) {
+  auto IsSpilled = [&](RISCVMOperand *op) {
+    auto vreg = dynamic_cast<VirRegister *>(op);
+    return vreg != nullptr && spilled.count(vreg);
+  };
+  // 能重算的 vreg 原来的定值, 所有 use 改完之后再删
+  std::vector<RISCVMIR *> remated;
+  for (RISCVBasicBlock *block : blocks) {
+    std::unordered_map<VirRegister *, VirRegister *> cached;
+    auto track = [&](VirRegister *vreg, VirRegister *temp) {
+      temps.insert(temp);
+      if (origin.count(vreg))
+        unspillable.insert(temp);
+      else {
+        origin[temp] = vreg;
+        cached[vreg] = temp;
+      }
+    };
+    for (auto it = block->begin(); it != block->end();) {
+      RISCVMIR *mir = *it;
+      OpType Opcode = mir->GetOpcode();
+      if (Opcode == OpType::call) {
+        cached.clear();
+        ++it;
+        continue;
+      }
+      if (Opcode == OpType::ret) {
+        ++it;
+        continue;
+      }
+      if (IsSpilled(mir->GetDef()) && remat.count(mir->GetDef()->ignoreLA()) &&
+          remat[mir->GetDef()->ignoreLA()] == mir) {
+        remated.push_back(mir);
+        ++it;
+        continue;
+      }
+      // 复用的临时寄存器被溢出后, 它和自己栈槽之间的 load/store 就多余了
+      if ((Opcode == OpType::_ld || Opcode == OpType::_flw) &&
+          IsSpilled(mir->GetDef()) &&
+          origin.count(mir->GetDef()->as<VirRegister>()) &&
+          mir->GetOperand(0) ==
+              GetSpillSlot(mir->GetDef()->as<VirRegister>())) {
+        ++it;
+        delete mir;
+        continue;
+      }
+      if ((Opcode == OpType::_sd || Opcode == OpType::_fsw) &&
+          IsSpilled(mir->GetOperand(0)) &&
+          origin.count(mir->GetOperand(0)->as<VirRegister>()) &&
+          mir->GetOperand(1) ==
+              GetSpillSlot(mir->GetOperand(0)->as<VirRegister>())) {
+        ++it;
+        delete mir;
+        continue;
+      }
+      auto reload = [&](VirRegister *vreg) {
+        if (cached.count(vreg))
+          return cached[vreg];
+        VirRegister *temp = new VirRegister(vreg->GetType());
+        // li/地址计算每个 use 前重算一遍, 不占栈槽
+        if (remat.count(vreg)) {
+          it.insert_before(Rematerialize(remat[vreg], temp));
+          temps.insert(temp);
+          unspillable.insert(temp);
+          return temp;
+        }
+        it.insert_before(CreateLoad(vreg, temp));
+        track(vreg, temp);
+        return temp;
+      };
+      for (int i = 0; i < mir->GetOperandSize(); i++) {
+        RISCVMOperand *operand = mir->GetOperand(i);
+        if (auto sreg = dynamic_cast<StackRegister *>(operand)) {
+          if (sreg->GetParent() != nullptr || !IsSpilled(sreg->GetVreg()))
+            continue;
+          mir->SetOperand(i, new StackRegister(reload(sreg->GetVreg()),
+                                               sreg->GetOffset()));
+        } else if (IsSpilled(operand))
+          mir->SetOperand(i, reload(operand->as<VirRegister>()));
+      }
+      if (IsSpilled(mir->GetDef())) {
+        VirRegister *vreg = mir->GetDef()->as<VirRegister>();
+        VirRegister *temp = new VirRegister(vreg->GetType());
+        mir->SetDef(temp);
+        it.insert_after(CreateStore(vreg, temp));
+        cached.erase(vreg);
+        track(vreg, temp);
+      }
+      ++it;
+    }
+  }
+  for (auto mir : remated)
+    delete mir;
+}
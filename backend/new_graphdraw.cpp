@@ -9,6 +9,7 @@
 #include <cassert>
 #include <cstddef>
 #include <iostream>
+#include <limits>
 #include <ostream>
 #include <unordered_set>
 void GraphColor::RunOnFunc() {
@@ -17,12 +18,13 @@ void GraphColor::RunOnFunc() {
   CaculateLiveness();
   CaculateTopu(m_func->front());
   std::reverse(topu.begin(), topu.end());
-  for (auto &[key, val] : IG) {
+  IG.visit([&](MOperand key, std::vector<MOperand> &val) {
     Degree[key] = val.size();
-  }
+  });
   while (condition) {
     condition = false;
     CaculateLiveness();
+    CaculateSpillCost();
     MakeWorklist();
     do {
       if (!simplifyWorkList.empty())
@@ -45,10 +47,14 @@ void GraphColor::RunOnFunc() {
 }
 
 void GraphColor::MakeWorklist() {
-  for (auto node : initial) {
+  // 按编号处理, 工作表的顺序不依赖指针的哈希
+  std::vector<MOperand> nodes(initial.begin(), initial.end());
+  std::sort(nodes.begin(), nodes.end(),
+            [&](MOperand a, MOperand b) { return RegNum(a) < RegNum(b); });
+  for (auto node : nodes) {
     //添加溢出节点
     if (IG[node].size() > GetRegNums(node))
-      spillWorkList.insert(node);
+      PushSpillWorkList(node);
     else if (MoveRelated(node).size() != 0)
       freezeWorkList.insert(node);
     else {
@@ -57,10 +63,6 @@ void GraphColor::MakeWorklist() {
       simplifyWorkList.push_back(node);
     }
   }
-  AdjList.clear();
-  for (auto &[key, val] : IG) {
-    AdjList[key].insert(val.begin(), val.end());
-  }
 }
 
 std::unordered_set<RISCVMIR *> GraphColor::MoveRelated(MOperand v) {
@@ -94,9 +96,7 @@ bool GraphColor::GeorgeCheck(MOperand dst, MOperand src, RISCVType ty) {
         ok |= true;
       if (Precolored.find(tmp) != Precolored.end())
         ok |= true;
-      auto &adj = IG[dst];
-      auto iter = std::find(adj.begin(), adj.end(), tmp);
-      if (iter != adj.end())
+      if (IG.Interfere(dst, tmp))
         ok |= true;
       if (ok != true)
         return false;
@@ -108,9 +108,7 @@ bool GraphColor::GeorgeCheck(MOperand dst, MOperand src, RISCVType ty) {
         ok |= true;
       if (Precolored.find(tmp) != Precolored.end())
         ok |= true;
-      auto &adj = IG[dst];
-      auto iter = std::find(adj.begin(), adj.end(), tmp);
-      if (iter != adj.end())
+      if (IG.Interfere(dst, tmp))
         ok |= true;
       if (ok != true)
         return false;
@@ -164,7 +162,6 @@ void GraphColor::CaculateLiveness() {
     CalInstLive(b);
     CalcmoveList(b);
   }
-  RunOnFunc_();
 }
 
 void GraphColor::CaculateLiveInterval(RISCVBasicBlock *mbb) {
@@ -179,34 +176,60 @@ void GraphColor::CaculateLiveInterval(RISCVBasicBlock *mbb) {
   }
 }
 
-// TODO spill node的启发式函数
-/*
-  需要考虑的点：
-  1.活跃interval区间越大越优先选择溢出
-  2.度数越高越优先选择溢出
-  3.是否需要考虑loopcounter循环嵌套数
-*/
+void GraphColor::CaculateSpillCost() {
+  SpillCost.clear();
+  Remat.clear();
+  std::unordered_map<MOperand, int> defs;
+  auto update = [&](RISCVMOperand *op, double freq) {
+    if (op == nullptr)
+      return;
+    if (auto vreg = dynamic_cast<VirRegister *>(op->ignoreLA()))
+      SpillCost[vreg] += freq;
+  };
+  for (auto mbb : *m_func) {
+    double freq = std::pow(10, std::min(mbb->LoopDepth, 6));
+    for (auto mir : *mbb) {
+      update(mir->GetDef(), freq);
+      for (int i = 0; i < mir->GetOperandSize(); i++)
+        update(mir->GetOperand(i), freq);
+      if (auto vreg = dynamic_cast<VirRegister *>(mir->GetDef())) {
+        if (++defs[vreg] == 1 && isRematerializable(mir))
+          Remat[vreg] = mir;
+        else
+          Remat.erase(vreg);
+      }
+    }
+  }
+  for (auto &[vreg, cost] : SpillCost) {
+    if (SpillTemps.count(vreg))
+      cost = std::numeric_limits<double>::infinity();
+    else if (Remat.count(vreg))
+      cost /= 2;
+  }
+}
+
+void GraphColor::PushSpillWorkList(MOperand v) {
+  spillWorkList.insert(v);
+  int degree = std::max(Degree[v], 1);
+  SpillQueue.push(
+      SpillCandidate{SpillCost[v] / degree, RegNum(v), Degree[v], v});
+}
+
+/// @brief 代价 = sum(10^循环深度) / 度数, 取最小的; 内层循环里的值最后才溢出
 MOperand GraphColor::HeuristicSpill() {
-  int max = 0;
-  for (auto spill : spillWorkList) {
-    auto vspill = dynamic_cast<VirRegister *>(spill);
-    if (AlreadySpill.find(vspill) != AlreadySpill.end())
+  while (!SpillQueue.empty()) {
+    SpillCandidate top = SpillQueue.top();
+    SpillQueue.pop();
+    if (spillWorkList.find(top.reg) == spillWorkList.end())
       continue;
-    return spill;
-    float weight = 0;
-    //考虑degree
-    int degree = IG[spill].size();
-    weight += (degree * DegreeWeight) << 2;
-    //考虑interval区间
-    int intervalLength = ValsInterval[spill];
-    weight += (intervalLength * livenessWeight) << 3;
-    //考虑嵌套层数
-    int loopdepth; // TODO
-    // weight /= std::pow(LoopWeight, loopdepth);
+    if (top.degree != Degree[top.reg]) {
+      PushSpillWorkList(top.reg);
+      continue;
+    }
+    return top.reg;
   }
-  for (auto spill : spillWorkList)
-    return spill;
-  assert(0);
+  assert(spillWorkList.empty());
+  return nullptr;
 }
 
 // TODO选择freeze node的启发式函数
@@ -254,6 +277,7 @@ void GraphColor::combine(MOperand rd, MOperand rs) {
     spillWorkList.erase(rs);
   coalescedNodes.insert(rs);
   alias[rs] = rd;
+  SpillCost[rd] += SpillCost[rs];
   //更新合并后的movelist,干涉图
   for (auto mv : moveList[rs]) {
     moveList[rd].insert(mv);
@@ -275,16 +299,15 @@ void GraphColor::combine(MOperand rd, MOperand rs) {
                      << rd->GetName() << "]" << std::endl;)
     _DEBUG(std::cerr << "Push " << rd->GetName() << " Into IG["
                      << neighbor->GetName() << "]" << std::endl;)
-    PushVecSingleVal(IG[rd], neighbor);
-    PushVecSingleVal(IG[neighbor], rd);
+    IG.AddEdge(rd, neighbor);
     Degree[rd]++;
 
     //这里注意需要检查一下更新后的相邻边是否只有color-1
     if (neighbor->GetType() == riscv_i32 || neighbor->GetType() == riscv_ptr) {
       if (Degree[neighbor] == GetRegNums(riscv_i32) - 1) {
         spillWorkList.erase(neighbor);
-        std::unordered_set<MOperand> tmp(Adjacent(neighbor).begin(),
-                                         Adjacent(neighbor).end());
+        auto adj_neighbor = Adjacent(neighbor);
+        std::unordered_set<MOperand> tmp(adj_neighbor.begin(), adj_neighbor.end());
         tmp.insert(neighbor);
         // EnableMove
         for (auto node : tmp)
@@ -305,8 +328,8 @@ void GraphColor::combine(MOperand rd, MOperand rs) {
     } else if (neighbor->GetType() == riscv_float32) {
       if (Degree[neighbor] == GetRegNums(riscv_float32) - 1) {
         spillWorkList.erase(neighbor);
-        std::unordered_set<MOperand> tmp(Adjacent(neighbor).begin(),
-                                         Adjacent(neighbor).end());
+        auto adj_neighbor = Adjacent(neighbor);
+        std::unordered_set<MOperand> tmp(adj_neighbor.begin(), adj_neighbor.end());
         tmp.insert(neighbor);
         // EnableMove
         for (auto node : tmp)
@@ -329,7 +352,7 @@ void GraphColor::combine(MOperand rd, MOperand rs) {
   if (IG[rd].size() >= GetRegNums(rs) &&
       (freezeWorkList.find(rd) != freezeWorkList.end())) {
     freezeWorkList.erase(rd);
-    spillWorkList.insert(rd);
+    PushSpillWorkList(rd);
   }
 }
 
@@ -371,6 +394,7 @@ void GraphColor::simplify() {
   auto val = simplifyWorkList.back();
   simplifyWorkList.pop_back();
   selectstack.push_back(val);
+  selected.set(RegNum(val));
   _DEBUG(std::cerr << "SelectStack Insert: " << val->GetName() << std::endl;)
   //此时需要更新冲突图上和当前val相邻的边(DecrementDegree)
   auto adj = Adjacent(val);
@@ -380,8 +404,8 @@ void GraphColor::simplify() {
     if (target->GetType() == riscv_i32 || target->GetType() == riscv_ptr) {
       if (Degree[target] == GetRegNums(riscv_i32) - 1) {
         spillWorkList.erase(target);
-        std::unordered_set<MOperand> tmp(Adjacent(target).begin(),
-                                         Adjacent(target).end());
+        auto adj_target = Adjacent(target);
+        std::unordered_set<MOperand> tmp(adj_target.begin(), adj_target.end());
         tmp.insert(target);
         // EnableMove
         for (auto node : tmp)
@@ -402,8 +426,8 @@ void GraphColor::simplify() {
     } else if (target->GetType() == riscv_float32) {
       if (Degree[target] == GetRegNums(riscv_float32) - 1) {
         spillWorkList.erase(target);
-        std::unordered_set<MOperand> tmp(Adjacent(target).begin(),
-                                         Adjacent(target).end());
+        auto adj_target = Adjacent(target);
+        std::unordered_set<MOperand> tmp(adj_target.begin(), adj_target.end());
         tmp.insert(target);
         // EnableMove
         for (auto node : tmp)
@@ -444,16 +468,12 @@ void GraphColor::coalesce() {
     vec_pop(worklistMoves, i);
     // moveList[rs].erase(mv);
     // moveList[rd].erase(mv);
-    auto iter = std::find(IG[rs].begin(), IG[rs].end(), rd);
-    std::unordered_set<MOperand> Adjset(IG[rs].begin(), IG[rs].end());
-    for (auto tmp : IG[rd])
-      Adjset.insert(tmp);
     if (m.first == m.second) {
       // means we use the : r1 <- r1 ,chich can be simplify
       coalescedMoves.push_back(mv);
       AddWorkList(m.first);
     } else if (Precolored.find(m.second) != Precolored.end() ||
-               iter != IG[rs].end()) {
+               IG.Interfere(rs, rd)) {
       // two oprand are all reg or the rs and rd are in IG
       constrainedMoves.insert(mv);
       AddWorkList(m.first);
@@ -498,6 +518,7 @@ void GraphColor::AssignColors() {
     MOperand select = selectstack.back();
     RISCVType ty = select->GetType();
     selectstack.pop_back();
+    selected.reset(RegNum(select));
     std::unordered_set<MOperand> int_assist{reglist.GetReglistInt().begin(),
                                             reglist.GetReglistInt().end()};
     std::unordered_set<MOperand> float_assist{reglist.GetReglistFloat().begin(),
@@ -540,88 +561,11 @@ void GraphColor::AssignColors() {
 }
 
 void GraphColor::SpillNodeInMir() {
-  std::unordered_set<VirRegister *> temps;
-  for (const auto mbb : topu) {
-    for (auto mir_begin = mbb->begin(), mir_end = mbb->end();
-         mir_begin != mir_end;) {
-      auto mir = *mir_begin;
-      if (mir->GetOpcode() == RISCVMIR::call ||
-          mir->GetOpcode() == RISCVMIR::ret) {
-        ++mir_begin;
-        continue;
-      }
-      if (mir->GetDef() != nullptr &&
-          dynamic_cast<VirRegister *>(mir->GetDef()) &&
-          (spilledNodes.find(dynamic_cast<VirRegister *>(mir->GetDef())) !=
-           spilledNodes.end()) &&
-          AlreadySpill.find(dynamic_cast<VirRegister *>(mir->GetDef())) ==
-              AlreadySpill.end()) {
-        //存在def并且def是一个准备spill节点
-        RISCVMIR *sd = CreateSpillMir(mir->GetDef(), temps);
-        mir_begin.insert_after(sd);
-        _DEBUG(std::cerr
-                   << "Spilling "
-                   << dynamic_cast<VirRegister *>(mir->GetDef())->GetName()
-                   << ", Use Vreg "
-                   << dynamic_cast<VirRegister *>(sd->GetOperand(0))->GetName()
-                   << " To Replace" << std::endl;)
-        mir->SetDef(sd->GetOperand(0));
-      } else if (mir->GetDef() != nullptr &&
-                 dynamic_cast<VirRegister *>(mir->GetDef()) &&
-                 (spilledNodes.find(dynamic_cast<VirRegister *>(
-                      mir->GetDef())) != spilledNodes.end())) {
-        //存在def并且def是一个已经spill节点
-        RISCVMIR *ld =
-            CreateLoadMir(dynamic_cast<VirRegister *>(mir->GetDef()), temps);
-        mir_begin.insert_before(ld);
-        _DEBUG(
-            std::cerr << "Find a Spilled Node "
-                      << dynamic_cast<VirRegister *>(mir->GetDef())->GetName()
-                      << ", Use Vreg "
-                      << dynamic_cast<VirRegister *>(ld->GetDef())->GetName()
-                      << " To Replace" << std::endl;)
-        mir->SetDef(ld->GetDef());
-      }
-      for (int i = 0; i < mir->GetOperandSize(); i++) {
-        auto operand = mir->GetOperand(i);
-        if (operand != nullptr && dynamic_cast<VirRegister *>(operand) &&
-            (spilledNodes.find(dynamic_cast<VirRegister *>(operand)) !=
-             spilledNodes.end()) &&
-            AlreadySpill.find(dynamic_cast<VirRegister *>(operand)) ==
-                AlreadySpill.end()) {
-          //存在operand(i)并且operand(i)是一个准备spill节点
-          RISCVMIR *sd = CreateSpillMir(operand, temps);
-          mir_begin.insert_after(sd);
-          _DEBUG(
-              std::cout
-                  << "Spilling "
-                  << dynamic_cast<VirRegister *>(mir->GetOperand(i))->GetName()
-                  << ", Use Vreg "
-                  << dynamic_cast<VirRegister *>(sd->GetOperand(0))->GetName()
-                  << " To Replace" << std::endl;)
-          mir->SetOperand(i, sd->GetOperand(0));
-          // temps.insert(dynamic_cast<VirRegister *>(sd->GetOperand(0)));
-        } else if (mir->GetOperand(i) != nullptr &&
-                   dynamic_cast<VirRegister *>(mir->GetOperand(i)) &&
-                   (spilledNodes.find(dynamic_cast<VirRegister *>(
-                        mir->GetOperand(i))) != spilledNodes.end())) {
-          //存在operand(i)并且operand(i)是一个已经spill节点
-          RISCVMIR *ld = CreateLoadMir(mir->GetOperand(i), temps);
-          mir_begin.insert_before(ld);
-          _DEBUG(
-              std::cerr
-                  << "Find a Spilled Node "
-                  << dynamic_cast<VirRegister *>(mir->GetOperand(i))->GetName()
-                  << ", Use Vreg "
-                  << dynamic_cast<VirRegister *>(ld->GetDef())->GetName()
-                  << " To Replace" << std::endl;)
-          mir->SetOperand(i, ld->GetDef());
-          // temps.insert(dynamic_cast<VirRegister *>(ld->GetDef()));
-        }
-      }
-      ++mir_begin;
-    }
-  }
+  std::unordered_set<VirRegister *> temps, spilled;
+  for (auto node : spilledNodes)
+    spilled.insert(node->as<VirRegister>());
+  // 区间在块边界和 call 处切开, 段内复用一个临时寄存器
+  rewriter.Rewrite(topu, spilled, Remat, temps, SpillTemps);
   spilledNodes.clear();
   initial.clear();
   initial.insert(coloredNode.begin(), coloredNode.end());
@@ -631,45 +575,6 @@ void GraphColor::SpillNodeInMir() {
   coloredNode.clear();
 }
 
-RISCVMIR *GraphColor::CreateSpillMir(RISCVMOperand *spill,
-                                     std::unordered_set<VirRegister *> &temps) {
-  auto vreg = dynamic_cast<VirRegister *>(spill);
-  assert(vreg && "the chosen operand must be a vreg");
-  assert(AlreadySpill.find(vreg) == AlreadySpill.end() && "no spill before");
-  VirRegister *reg = new VirRegister(vreg->GetType());
-  temps.insert(reg);
-  RISCVMIR *sd = nullptr;
-  if (spill->GetType() == RISCVType::riscv_i32 ||
-      spill->GetType() == RISCVType::riscv_ptr)
-    sd = new RISCVMIR(RISCVMIR::RISCVISA::_sd);
-  else if (spill->GetType() == RISCVType::riscv_float32)
-    sd = new RISCVMIR(RISCVMIR::RISCVISA::_fsw);
-  sd->AddOperand(reg);
-  auto spillnode = m_func->GetFrame()->spill(vreg);
-  sd->AddOperand(spillnode);
-  AlreadySpill[vreg] = sd;
-  return sd;
-}
-
-RISCVMIR *GraphColor::CreateLoadMir(RISCVMOperand *load,
-                                    std::unordered_set<VirRegister *> &temps) {
-  auto vreg = dynamic_cast<VirRegister *>(load);
-  assert(vreg && "the chosen operand must be a vreg");
-  assert(AlreadySpill.find(vreg) != AlreadySpill.end() && "no spill before");
-  VirRegister *reg = new VirRegister(vreg->GetType());
-  temps.insert(reg);
-  RISCVMIR *lw = nullptr;
-  if (load->GetType() == RISCVType::riscv_i32 ||
-      load->GetType() == RISCVType::riscv_ptr)
-    lw = new RISCVMIR(RISCVMIR::RISCVISA::_ld);
-  else if (load->GetType() == RISCVType::riscv_float32)
-    lw = new RISCVMIR(RISCVMIR::RISCVISA::_flw);
-  auto loadnode = AlreadySpill[vreg]->GetOperand(1);
-  lw->SetDef(reg);
-  lw->AddOperand(loadnode);
-  return lw;
-}
-
 void GraphColor::RewriteProgram() {
   for (const auto mbb : topu) {
     for (auto mir : *mbb) {
@@ -797,6 +702,8 @@ void GraphColor::CaculateTopu(RISCVBasicBlock *mbb) {
 
 void GraphColor::GC_init() {
   ValsInterval.clear();
+  SpillTemps.clear();
+  SpillQueue = {};
   freezeWorkList.clear();
   worklistMoves.clear();
   simplifyWorkList.clear();
@@ -809,31 +716,29 @@ void GraphColor::GC_init() {
   coalescedMoves.clear();
   frozenMoves.clear();
   coloredNode.clear();
-  AdjList.clear();
   selectstack.clear();
+  selected.clear();
   belongs.clear();
   activeMoves.clear();
   alias.clear();
   RegType.clear();
-  AlreadySpill.clear();
-  InstLive.clear();
   Precolored.clear();
   color.clear();
   moveList.clear();
   IG.clear();
+  RegNum.clear();
   instNum.clear();
   RegLiveness.clear();
   assist.clear();
   topu.clear();
 }
 
-std::set<MOperand> GraphColor::Adjacent(MOperand val) {
-  std::set<MOperand> tmp;
+std::vector<MOperand> GraphColor::Adjacent(MOperand val) {
+  std::vector<MOperand> tmp;
   for (auto _val : IG[val]) {
-    auto it_1 = std::find(selectstack.begin(), selectstack.end(), val);
-    if (it_1 == selectstack.end() &&
-        coalescedNodes.find(val) == coalescedNodes.end()) {
-      tmp.insert(_val);
+    if (!selected.test(RegNum(_val)) &&
+        coalescedNodes.find(_val) == coalescedNodes.end()) {
+      tmp.push_back(_val);
     }
   }
   return tmp;
@@ -0,0 +1,36 @@
+#pragma once
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/// @brief 汇编输出缓冲, 各个 print 往这里写而不是 std::cout
+/// @note 整个 .s 先在内存里格式化好, 最后一次写出; 整数用 to_chars, 不走 iostream 的 locale
+class AsmEmitter{
+    std::string buffer;
+    public:
+    AsmEmitter(size_t reserve=1<<16){buffer.reserve(reserve);}
+    AsmEmitter& operator<<(std::string_view str){
+        buffer.append(str.data(),str.size());
+        return *this;
+    }
+    AsmEmitter& operator<<(const char* str){return *this<<std::string_view(str);}
+    AsmEmitter& operator<<(const std::string& str){return *this<<std::string_view(str);}
+    AsmEmitter& operator<<(char ch){
+        buffer.push_back(ch);
+        return *this;
+    }
+    template<typename T,std::enable_if_t<std::is_integral_v<T>&&!std::is_same_v<T,char>&&!std::is_same_v<T,bool>,int> =0>
+    AsmEmitter& operator<<(T val){
+        char buf[24];
+        auto res=std::to_chars(buf,buf+sizeof(buf),val);
+        buffer.append(buf,res.ptr);
+        return *this;
+    }
+    /// @brief 接上另一个缓冲的内容, 用于拼接各个函数单独格式化的结果
+    AsmEmitter& operator<<(const AsmEmitter& other){return *this<<std::string_view(other.buffer);}
+    const std::string& str()const{return buffer;}
+    size_t size()const{return buffer.size();}
+    /// @brief 整个缓冲写进文件, 失败返回 false
+    bool WriteTo(const std::string& path)const;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include "../../include/backend/BackendPass.hpp"
+#include "../../include/backend/RISCVMIR.hpp"
+#include <map>
+#include <vector>
+
+/// @brief 基本块排布, 让热的边变成顺序执行, 少跳一次
+/// @note 边权按循环深度估频率, 条件跳转两边按静态启发式分: 留在循环里的一边, 不直接返回的一边, 往回跳的一边更热
+/// @note 从最热的边开始把块连成链(Pettis-Hansen), 回边权重最高, 循环会被转成 body; header 的形状, 每次迭代只剩一条条件跳转
+/// @note 排好之后 j 到下一块的删掉, b<cc> 到下一块的反转条件去跳原来 j 的目标
+class BlockPlacement:public BackEndPass<RISCVFunction>{
+    struct Edge{
+        RISCVBasicBlock* from;
+        RISCVBasicBlock* to;
+        double weight;
+        bool backedge;
+    };
+    RISCVFunction* func;
+    /// @brief 原来的顺序, 打破平局和排链用
+    std::map<RISCVBasicBlock*,int> order;
+    std::vector<Edge> edges;
+
+    void BuildEdges();
+    std::vector<RISCVBasicBlock*> BuildLayout();
+    bool FixBranches(std::vector<RISCVBasicBlock*>&);
+    public:
+    bool run(RISCVFunction*)override;
+    /// @brief beq<->bne, blt<->bge, ble<->bgt, bltu<->bgeu
+    static RISCVMIR::RISCVISA InvertBranch(RISCVMIR::RISCVISA);
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include "../../include/backend/BackendPass.hpp"
+#include "../../include/backend/RISCVMIR.hpp"
+#include <map>
+#include <vector>
+
+/// @brief 寄存器分配之后的跳转化简
+/// @note PhiElimination 给每条关键边插的拷贝块, 分配后很多只剩一条 j, 这里把它们跳过去
+/// @note b<cc> .., T; j T 折成 j T; j S 而 S 只有这一个前驱时把 S 接过来; 最后删掉没人跳到的块
+class BranchFolding:public BackEndPass<RISCVFunction>{
+    RISCVFunction* func;
+    /// @brief 每个块被多少条跳转指令引用
+    std::map<RISCVBasicBlock*,int> refs;
+
+    void CountRefs();
+    bool ThreadJumps();
+    bool FoldCondBranches();
+    bool MergeBlocks();
+    bool RemoveDeadBlocks();
+    public:
+    bool run(RISCVFunction*)override;
+    static bool isBranch(RISCVMIR*);
+    static std::vector<RISCVMIR*> GetBranches(RISCVBasicBlock*);
+};
@@ -12,6 +12,7 @@ class tempvar;
 class functionSegment;
 class textSegment;
 class dataSegment;
+class RISCVObjectWriter;
 enum SegmentType {
     TEXT,
     DATA,
@@ -19,7 +20,7 @@ enum SegmentType {
     RODATA
 };
 SegmentType ChangeSegmentType(SegmentType newtype);
-void PrintSegmentType(SegmentType newtype, SegmentType* oldtype);
+void PrintSegmentType(AsmEmitter& out, SegmentType newtype, SegmentType* oldtype);
 class RISCVAsmPrinter {
     protected:
     std::string filename;
@@ -30,8 +31,10 @@ class RISCVAsmPrinter {
     ~RISCVAsmPrinter() = default;
     void SetTextSegment(textSegment*);
     dataSegment*& GetData();
-    void printAsmGlobal();
-    void printAsm();
+    void printAsmGlobal(AsmEmitter&);
+    void printAsm(AsmEmitter&);
+    /// @brief 和 printAsm 同样的内容, 直接编码进目标文件
+    void emitObject(RISCVObjectWriter&);
 };
 
 class dataSegment {
@@ -46,8 +49,10 @@ class dataSegment {
     void GenerateTempvarList(RISCVLoweringContext& ctx);
     std::vector<tempvar*> get_tempvar_list();
     void Change_LoadConstFloat(RISCVMIR* inst, tempvar* tempfloat, mylist<RISCVBasicBlock,RISCVMIR>::iterator it, Imm* used);
-    void PrintDataSegment_Globval();
-    void PrintDataSegment_Tempvar();
+    void PrintDataSegment_Globval(AsmEmitter&);
+    void PrintDataSegment_Tempvar(AsmEmitter&);
+    void EmitDataSegment_Globval(RISCVObjectWriter&);
+    void EmitDataSegment_Tempvar(RISCVObjectWriter&);
     void LegalizeGloablVar(RISCVLoweringContext&);
 };
 
@@ -57,12 +62,18 @@ class globlvar: public RISCVGlobalObject{
     int align;
     std::string ty="object";
     int size;
-    std::vector<std::variant<int , float>> init_vector;
+    // 只放 memcpy 用的常量模板, 进 .rodata
+    bool readonly;
+    /// @brief 只记非零元素: <相对开头的字节偏移, 值>, 按偏移升序
+    /// @note 零元素不占内存, 打印时相邻非零元素之间补 .zero; 全零的放 .bss
+    std::vector<std::pair<size_t, std::variant<int , float>>> init_vector;
+    void push_init(Value* val, size_t offset);
     public:
     globlvar(Variable* data);
     ~globlvar() = default;
-    void generate_array_init(Initializer* arry_init, Type* basetype);
-    void PrintGloblvar();
+    void generate_array_init(Initializer* arry_init, size_t offset);
+    void PrintGloblvar(AsmEmitter&);
+    void EmitGloblvar(RISCVObjectWriter&);
 };
 
 class tempvar: public RISCVTempFloatObject{
@@ -76,7 +87,8 @@ class tempvar: public RISCVTempFloatObject{
     ~tempvar() = default;
     std::string Getname();
     float GetInit() {return init;}
-    void PrintTempvar();
+    void PrintTempvar(AsmEmitter&);
+    void EmitTempvar(RISCVObjectWriter&);
 };
 
 class textSegment {
@@ -85,7 +97,8 @@ class textSegment {
     public:
     textSegment(RISCVLoweringContext& ctx);
     void GenerateFuncList(RISCVLoweringContext& ctx);
-    void PrintTextSegment();
+    void PrintTextSegment(AsmEmitter&);
+    void EmitTextSegment(RISCVObjectWriter&);
 };
 
 class functionSegment {
@@ -98,5 +111,6 @@ class functionSegment {
     int size;
     public:
     functionSegment(RISCVFunction* func);
-    void PrintFuncSegment();
+    void PrintFuncSegment(AsmEmitter&);
+    void EmitFuncSegment(RISCVObjectWriter&);
 };
\ No newline at end of file
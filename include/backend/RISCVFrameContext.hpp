@@ -9,7 +9,7 @@ class NamedMOperand:public RISCVMOperand{
     public:
     std::string& GetName();
     NamedMOperand(std::string,RISCVType);
-    void print()override;
+    void print(AsmEmitter&)override;
 };
 
 /// @brief A ptr type to some mem address
@@ -26,13 +26,13 @@ class RISCVObject:public NamedMOperand{
 class RISCVGlobalObject:public RISCVObject{
     public:
     RISCVGlobalObject(Type*,std::string name);
-    void print()override;
+    void print(AsmEmitter&)override;
 };
 
 class RISCVTempFloatObject:public RISCVObject{
     public:
     RISCVTempFloatObject(std::string name);
-    void print()override;
+    void print(AsmEmitter&)override;
 };
 
 
@@ -57,7 +57,7 @@ class RISCVFrameObject:public RISCVMOperand{
     void SetBeginAddOff(size_t);
     void SetEndAddOff(size_t);
     StackRegister*& GetStackReg();
-    void print()override;
+    void print(AsmEmitter&)override;
 };
 
 class BegAddrRegister:public Register{
@@ -65,7 +65,7 @@ class BegAddrRegister:public Register{
     public:
     BegAddrRegister(RISCVFrameObject*);
     // BegAddrRegister(size_t);
-    void print()final;
+    void print(AsmEmitter&)final;
     RISCVFrameObject*& GetFrameObj() {return frameobj;}
     std::string GetName() {return rname;}
     bool isPhysical()final{return true;}
@@ -88,6 +88,6 @@ class StackRegister:public Register{
     void SetPreg(PhyRegister*&);
     void SetReg(Register*);
     void SetOffset(int);
-    void print()final;
+    void print(AsmEmitter&)final;
     bool isPhysical()final;
 };
\ No newline at end of file
@@ -8,6 +8,10 @@
 #include <algorithm>
 
 void LowerFormalArguments(Function* func, RISCVLoweringContext& ctx);
+/// @brief 乘除模常数改成移位/加减/魔数乘法, 不适用时返回 false
+bool LowerConstMul(BinaryInst* inst, RISCVLoweringContext& ctx);
+bool LowerConstDiv(BinaryInst* inst, RISCVLoweringContext& ctx);
+bool LowerConstMod(BinaryInst* inst, RISCVLoweringContext& ctx);
 
 class RISCVISel:public BackEndPass<Function>{
     RISCVLoweringContext& ctx;
@@ -36,6 +40,8 @@ class RISCVISel:public BackEndPass<Function>{
     //
     void InstLowering(CallInst*);
     void InstLowering(RetInst*);
+    /// @brief 紧跟着返回它的 ret, 实参都在寄存器里且不指向当前栈帧的 call
+    bool IsSiblingCall(CallInst*,std::vector<int>& spillnodes);
 
     void InstLowering(ZextInst*);
  
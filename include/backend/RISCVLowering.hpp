@@ -12,8 +12,12 @@
 class RISCVModuleLowering:BackEndPass<Module>{
     // bool LoweringGlobalValue(Module*);
     RISCVLoweringContext ctx;
+    std::string output;
+    // 直接写 .o 而不是 .s
+    bool object;
     void LowerGlobalArgument(Module*); 
     public:
+    RISCVModuleLowering(std::string output,bool object=false):output(output),object(object){};
     bool run(Module*);
 };
 
@@ -23,6 +23,13 @@ class RISCVMIR:public list_node<RISCVBasicBlock,RISCVMIR>
         // shift right arithmetic
         _sra,
         _srai,
+        // 32 位移位, 结果符号扩展到 64 位
+        _sllw,
+        _slliw,
+        _srlw,
+        _srliw,
+        _sraw,
+        _sraiw,
         EndShift,
         
         
@@ -170,6 +177,8 @@ class RISCVMIR:public list_node<RISCVBasicBlock,RISCVMIR>
         mv,
         call,
         ret,
+        // 复用当前栈帧的调用, 先恢复现场再跳过去, 被调函数直接返回到调用者的调用者
+        tail,
         li,
 
         // LocalVariableAddr <- MOperand, no register allocation
@@ -208,7 +217,14 @@ class RISCVMIR:public list_node<RISCVBasicBlock,RISCVMIR>
     bool isArithmetic(){
         return (EndArithmetic>opcode&&opcode>BeginArithmetic)|(EndFloatArithmetic>opcode&&opcode>BeginFloatArithmetic);
     }
-    void printfull();
+    void printfull(AsmEmitter&);
+};
+
+/// @note 指令数超过了 magic_enum 默认的 [-128,127]
+template <>
+struct magic_enum::customize::enum_range<RISCVMIR::RISCVISA> {
+    static constexpr int min = 0;
+    static constexpr int max = 255;
 };
 
 class RISCVBasicBlock:public NamedMOperand,public mylist<RISCVBasicBlock,RISCVMIR>,public list_node<RISCVFunction,RISCVBasicBlock>
@@ -218,8 +234,10 @@ class RISCVBasicBlock:public NamedMOperand,public mylist<RISCVBasicBlock,RISCVMI
     RISCVBasicBlock(std::string);
     static RISCVBasicBlock* CreateRISCVBasicBlock();
     void push_before_branch(RISCVMIR*);
-    void printfull();
+    void printfull(AsmEmitter&);
     void replace_succ(RISCVBasicBlock*,RISCVBasicBlock*);
+    /// @brief 从对应 IR 块的 LoopDepth 抄过来, 寄存器分配时用来估计溢出代价
+    int LoopDepth=0;
 };
 
 /// should we save return type here? I suppose not.
@@ -234,6 +252,8 @@ class RISCVFunction:public RISCVGlobalObject,public mylist<RISCVFunction,RISCVBa
     size_t max_param_size=0;
     /// @brief save the index of the params of func's paramlist that should be spilled
     std::vector<int> param_need_spill;
+    /// @brief ISel 判定后面紧跟着 ret 的 call, 寄存器分配之后由 SiblingCall 改成 tail
+    std::vector<RISCVMIR*> sibling_calls;
     public:
     RISCVFunction(Value*);
     RISCVframe& GetFrame();
@@ -241,7 +261,8 @@ class RISCVFunction:public RISCVGlobalObject,public mylist<RISCVFunction,RISCVBa
     void SetMaxParamSize(size_t);
     void GenerateParamNeedSpill();
     std::vector<int>& GetParamNeedSpill();
-    void printfull();
+    std::vector<RISCVMIR*>& GetSiblingCalls(){return sibling_calls;}
+    void printfull(AsmEmitter&);
 
     inline RISCVBasicBlock* GetEntry(){return front();};
     inline RISCVBasicBlock* GetExit(){return &exit;};
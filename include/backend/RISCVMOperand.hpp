@@ -1,6 +1,7 @@
 #pragma once
 #include "../../include/backend/RISCVType.hpp"
 #include "../../include/lib/BaseCFG.hpp"
+#include "../../include/backend/AsmEmitter.hpp"
 class Register;
 /// @brief  Just need a type currently
 class RISCVMOperand{
@@ -8,7 +9,7 @@ class RISCVMOperand{
     public:
     RISCVMOperand(RISCVType _tp):tp(_tp){};
     RISCVType GetType(){return tp;}
-    virtual void print()=0;
+    virtual void print(AsmEmitter&)=0;
     template<typename T>
     T* as(){
         return dynamic_cast<T*>(this);
@@ -25,5 +26,5 @@ class Imm:public RISCVMOperand{
     Imm(ConstantData*);
     ConstantData* Getdata();
     static Imm* GetImm(ConstantData*);
-    void print()final;
+    void print(AsmEmitter&)final;
 };
\ No newline at end of file
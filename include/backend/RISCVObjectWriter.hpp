@@ -0,0 +1,50 @@
+#pragma once
+#include <elf.h>
+#include "../../include/backend/RISCVAsmPrinter.hpp"
+
+/// @brief 直接生成 RV64 的可重定位 ELF(.o), 不再经过汇编器
+/// @note 伪指令按汇编器的方式展开(li/mv/seqz/call/tail/ret...); 块之间的跳转在这里算好偏移,
+/// 超出范围的条件跳转改成反向条件跳转 + jal; 对符号的引用都留给链接器:
+/// call/tail 用 R_RISCV_CALL_PLT, %hi/%lo 用 R_RISCV_HI20/LO12_I/LO12_S
+class RISCVObjectWriter {
+    struct Section {
+        std::string name;
+        uint32_t type;
+        uint64_t flags;
+        size_t align = 1;
+        // .bss 不占文件, 只记 size
+        std::string bytes;
+        size_t size = 0;
+    };
+    struct Symbol {
+        std::string name;
+        SegmentType seg;
+        bool defined;
+        bool global;
+        unsigned char type;
+        size_t value = 0;
+        size_t size = 0;
+    };
+    struct Reloc {
+        size_t offset;
+        std::string symbol;
+        uint32_t type;
+    };
+    Section text{".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, 4};
+    Section data{".data", SHT_PROGBITS, SHF_ALLOC | SHF_WRITE};
+    Section bss{".bss", SHT_NOBITS, SHF_ALLOC | SHF_WRITE};
+    Section rodata{".rodata", SHT_PROGBITS, SHF_ALLOC};
+    std::vector<Symbol> symbols;
+    std::map<std::string, size_t> symindex;
+    std::vector<Reloc> relocs;
+    Section& GetSection(SegmentType seg);
+    Symbol& GetSymbol(const std::string& name);
+    public:
+    /// @brief 编码一个函数追加到 .text 并定义函数符号
+    void EmitFunction(RISCVFunction* func);
+    /// @brief 在 seg 里开一段 size 字节(初始为 0)并定义符号, 返回段内偏移
+    size_t DefineObject(const std::string& name, SegmentType seg, size_t align, size_t size, bool global);
+    void WriteWord(SegmentType seg, size_t offset, uint32_t word);
+    /// @brief 写出整个 ELF 文件, 失败返回 false
+    bool WriteTo(const std::string& path);
+};
@@ -42,7 +42,7 @@ class PhyRegister:public Register{
     public:
     static PhyRegister* GetPhyReg(PhyReg);
     PhyReg Getregenum(){return regenum;};
-    void print();
+    void print(AsmEmitter&);
     std::string GetName();
     bool isPhysical()final{return true;};
     /// @return (1<<regenum), if valid 
@@ -87,7 +87,7 @@ class VirRegister:public Register{
     public:
     VirRegister(RISCVType);
     std::string GetName();
-    void print()final;
+    void print(AsmEmitter&)final;
     bool isPhysical()final{return false;};
 };
 
@@ -102,7 +102,7 @@ class LARegister:public Register{
     LARegister(RISCVType, std::string);
     LARegister(RISCVType, std::string, LAReg);
     LARegister(RISCVType, std::string, VirRegister*);
-    void print()final;
+    void print(AsmEmitter&)final;
     Register*& GetVreg();
     void SetReg(PhyRegister*&);
     std::string GetName(){return rname;}
@@ -26,7 +26,12 @@ class RegAllocImpl {
 public:
   RegAllocImpl(RISCVFunction *func, RISCVLoweringContext &_ctx)
       : m_func(func), ctx(_ctx) {}
+  enum Allocator { GraphColoring, LinearScanning };
+  /// @brief 由命令行的优化等级决定, 低优化等级用编译更快的线性扫描
+  static Allocator allocator;
+  void run();
   void RunGCpass();
+  void RunLSpass();
   struct RegLiveInterval {
     int start;
     int end;
@@ -43,6 +48,93 @@ protected:
   int availble;
 };
 using MOperand = Register *;
+
+/// @brief 定值能在 use 前重新算一遍(li 立即数, 栈上对象的地址), 溢出时不用栈槽
+bool isRematerializable(RISCVMIR *def);
+/// @brief 在 use 前重新生成一条和 def 一样的指令, 结果放到 temp
+RISCVMIR *Rematerialize(RISCVMIR *def, VirRegister *temp);
+
+/// @brief 按寄存器编号存的位集合, 活跃变量和选择栈都用它
+/// @note 编号超出当前长度的位当作 0, set 时自动变长
+class BitVector {
+  std::vector<uint64_t> words;
+
+public:
+  bool test(int i) const {
+    return (i >> 6) < words.size() && (words[i >> 6] >> (i & 63) & 1);
+  }
+  void set(int i) {
+    if ((i >> 6) >= words.size())
+      words.resize((i >> 6) + 1);
+    words[i >> 6] |= 1ull << (i & 63);
+  }
+  void reset(int i) {
+    if ((i >> 6) < words.size())
+      words[i >> 6] &= ~(1ull << (i & 63));
+  }
+  void clear() { words.clear(); }
+  /// @return 是否有新的位被置上
+  bool operator|=(const BitVector &other);
+  void subtract(const BitVector &other);
+  bool operator==(const BitVector &other) const;
+  bool operator!=(const BitVector &other) const { return !(*this == other); }
+  /// @brief 从小到大访问每个置位的编号
+  template <typename F> void visit(F f) const {
+    for (int w = 0; w < words.size(); w++)
+      for (uint64_t bits = words[w]; bits; bits &= bits - 1)
+        f(w * 64 + __builtin_ctzll(bits));
+  }
+};
+
+/// @brief 一个函数里寄存器的稠密编号, 第一次遇到时分配
+struct RegNumbering {
+  std::unordered_map<MOperand, int> index;
+  std::vector<MOperand> regs;
+  int operator()(MOperand op) {
+    auto [it, inserted] = index.emplace(op, regs.size());
+    if (inserted)
+      regs.push_back(op);
+    return it->second;
+  }
+  MOperand operator[](int i) { return regs[i]; }
+  void clear() {
+    index.clear();
+    regs.clear();
+  }
+};
+
+/// @brief 冲突图, 下三角位矩阵判断两点是否相邻, 邻接表按加边顺序遍历
+class InterferenceGraph {
+  RegNumbering &num;
+  std::vector<uint64_t> matrix;
+  std::vector<std::vector<MOperand>> adj;
+  /// @brief 在图里出现过的点, 包括没有边的
+  std::vector<char> present;
+  static size_t Bit(int i, int j) {
+    if (i < j)
+      std::swap(i, j);
+    return (size_t)i * (i - 1) / 2 + j;
+  }
+  void Grow(int i);
+
+public:
+  InterferenceGraph(RegNumbering &_num) : num(_num) {}
+  bool Interfere(MOperand a, MOperand b);
+  /// @brief 无向边, 已经相邻或者是同一个点时什么也不做
+  void AddEdge(MOperand a, MOperand b);
+  std::vector<MOperand> &operator[](MOperand op);
+  template <typename F> void visit(F f) {
+    for (int i = 0; i < present.size(); i++)
+      if (present[i])
+        f(num[i], adj[i]);
+  }
+  void clear() {
+    matrix.clear();
+    adj.clear();
+    present.clear();
+  }
+};
+
 class BlockLiveInfo {
 private:
   void GetBlockLivein(RISCVBasicBlock *block);
@@ -56,11 +148,12 @@ private:
 
 public:
   std::map<RISCVBasicBlock*, std::list<RISCVBasicBlock*>> SuccBlocks;
-  std::map<RISCVBasicBlock *, std::unordered_set<MOperand>> Uses; // block uses
-  std::map<RISCVBasicBlock *, std::unordered_set<MOperand>> Defs; // block defs
-  std::map<RISCVBasicBlock *, std::set<MOperand>> BlockLivein;
-  std::map<RISCVBasicBlock *, std::set<MOperand>> BlockLiveout;
-  std::map<RISCVMIR *, std::set<MOperand>> InstLive;
+  // 寄存器编号, 下面的集合都按它存
+  RegNumbering RegNum;
+  std::unordered_map<RISCVBasicBlock *, BitVector> Uses; // block uses
+  std::unordered_map<RISCVBasicBlock *, BitVector> Defs; // block defs
+  std::unordered_map<RISCVBasicBlock *, BitVector> BlockLivein;
+  std::unordered_map<RISCVBasicBlock *, BitVector> BlockLiveout;
   // 机器寄存器的集合，每个寄存器都预先指派了一种颜色
   std::unordered_set<MOperand> Precolored; // reg
                                            //算法最后为每一个operand选择的颜色
@@ -69,13 +162,12 @@ public:
   std::unordered_map<MOperand, std::unordered_set<RISCVMIR *>>
       moveList;                                           // reg2mov
                                                           // interference graph
-  std::unordered_map<MOperand, std::vector<MOperand>> IG; // reg2reg IG[op]
+  InterferenceGraph IG; // reg2reg IG[op]
   void RunOnFunction();
   void PrintPass();
-  bool count(MOperand Op, RISCVMIR *inst) { return InstLive[inst].count(Op); }
   bool Count(Register *op);
   BlockLiveInfo(RISCVFunction *f)
-      : m_func(f), BlockLivein{}, BlockLiveout{}, InstLive{} {}
+      : m_func(f), BlockLivein{}, BlockLiveout{}, IG(RegNum) {}
 };
 class LiveInterval : public BlockLiveInfo {
   using Interval = RegAllocImpl::RegLiveInterval;
@@ -102,6 +194,32 @@ public:
   void RunOnFunc_();
   void PrintAnalysis();
 };
+/// @brief 把溢出的 vreg 改写成栈槽访问, 两个分配器共用
+/// @note 区间在块边界和 call 处切开: 每段里第一次 use 时 load 到临时寄存器,
+/// 段里后面的 use 接着用, def 之后存回栈槽; 这样 call 之间的值可以待在
+/// caller-saved 里, 只在切开的地方存取. 段内复用的临时寄存器再被溢出时每个
+/// use/def 单独 load/store, 保证分配能收敛
+class SpillRewriter {
+  RISCVFunction *m_func;
+  // 段内复用的临时寄存器 -> 原来的 vreg, 再溢出时直接用原来的栈槽
+  std::unordered_map<VirRegister *, VirRegister *> origin;
+  std::unordered_map<VirRegister *, StackRegister *> slots;
+  RISCVMIR *CreateLoad(VirRegister *vreg, VirRegister *temp);
+  RISCVMIR *CreateStore(VirRegister *vreg, VirRegister *temp);
+
+public:
+  SpillRewriter(RISCVFunction *func) : m_func(func) {}
+  StackRegister *GetSpillSlot(VirRegister *vreg);
+  /// @param remat 能重算的 vreg 的定值, 在 use 前重算而不是 load
+  /// @param temps 新生成的临时寄存器
+  /// @param unspillable 其中不能再溢出的临时寄存器
+  void Rewrite(const std::vector<RISCVBasicBlock *> &blocks,
+               const std::unordered_set<VirRegister *> &spilled,
+               std::unordered_map<MOperand, RISCVMIR *> &remat,
+               std::unordered_set<VirRegister *> &temps,
+               std::unordered_set<MOperand> &unspillable);
+};
+
 class GraphColor : public LiveInterval {
 public:
   RISCVLoweringContext &ctx;
@@ -110,7 +228,7 @@ public:
   using IntervalLength = unsigned int;
   GraphColor(RISCVFunction *func, RISCVLoweringContext &_ctx)
       : LiveInterval(func), ctx(_ctx), m_func(func),
-        reglist(RegisterList::GetPhyRegList()) {}
+        reglist(RegisterList::GetPhyRegList()), rewriter(func) {}
   void RunOnFunc();
 private:
   /// @brief 初始化各个工作表
@@ -118,7 +236,8 @@ private:
   //返回vector为0则不是move相关
   std::unordered_set<RISCVMIR *> MoveRelated(MOperand v);
   void CalcmoveList(RISCVBasicBlock *block);
-  void CalcIG(RISCVMIR* inst);
+  /// @brief live 是 inst 处同时活跃的寄存器, 两两加边
+  void CalcIG(RISCVMIR* inst, BitVector &live);
   void CalInstLive(RISCVBasicBlock *block);
   void CaculateLiveness();
   void CaculateLiveInterval(RISCVBasicBlock *mbb);
@@ -130,6 +249,9 @@ private:
   void SpillNodeInMir();
   void RewriteProgram();
   void CaculateTopu(RISCVBasicBlock* mbb);
+  /// @brief 每个 use/def 按 10^循环深度 计入溢出代价, 能重算的只算一半
+  void CaculateSpillCost();
+  void PushSpillWorkList(MOperand v);
   MOperand HeuristicFreeze();
   MOperand HeuristicSpill();
   PhyRegister *SelectPhyReg(MOperand vreg,RISCVType ty, std::unordered_set<MOperand> &assist);
@@ -144,14 +266,31 @@ private:
   int GetRegNums(RISCVType ty);
   void GC_init();
   void LiveInfoInit();
-  std::set<MOperand> Adjacent(MOperand);
-  RISCVMIR *CreateSpillMir(RISCVMOperand *spill,
-                           std::unordered_set<VirRegister *> &temps);
-  RISCVMIR *CreateLoadMir(RISCVMOperand *load,
-                          std::unordered_set<VirRegister *> &temps);
+  std::vector<MOperand> Adjacent(MOperand);
   void Print();
   //保证Interval vector的顺序
   std::unordered_map<MOperand, IntervalLength> ValsInterval;
+  // 溢出代价, HeuristicSpill 再除以当前度数
+  std::unordered_map<MOperand, double> SpillCost;
+  // 只有一个定值且定值可以重算的 vreg
+  std::unordered_map<MOperand, RISCVMIR *> Remat;
+  // 溢出改写时生成的临时寄存器, 区间只跨一条指令, 再溢出没有意义
+  std::unordered_set<MOperand> SpillTemps;
+  /// @brief 溢出候选, 按 代价/度数 从小到大, 相同时按寄存器编号, 结果和遍历顺序无关
+  struct SpillCandidate {
+    double priority;
+    int id;
+    int degree;
+    MOperand reg;
+    bool operator>(const SpillCandidate &other) const {
+      return priority != other.priority ? priority > other.priority
+                                        : id > other.id;
+    }
+  };
+  // 度数变了的候选在弹出时重新算优先级再放回去
+  std::priority_queue<SpillCandidate, std::vector<SpillCandidate>,
+                      std::greater<SpillCandidate>>
+      SpillQueue;
   enum MoveState { coalesced, constrained, frozen, worklist, active };
   // 低度数的传送有关节点表
   std::unordered_set<MOperand> freezeWorkList;
@@ -175,10 +314,11 @@ private:
   std::unordered_set<RISCVMIR *> frozenMoves;
   //已成功着色的结点集合
   std::unordered_set<MOperand> coloredNode;
-  std::unordered_map<MOperand, std::unordered_set<MOperand>> AdjList;
   std::unordered_map<MOperand,int> Degree;
   // 从图中删除的临时变量的栈
   std::vector<MOperand> selectstack;
+  // selectstack 里的点, 按 RegNum 编号
+  BitVector selected;
   //查询每个传送指令属于哪一个集合
   std::unordered_map<RISCVMIR *, MoveState> belongs;
   // 还未做好准备的传送指令集合
@@ -186,12 +326,53 @@ private:
   //合并后的别名管理
   std::unordered_map<MOperand, MOperand> alias;
   std::unordered_map<PhyRegister *, RISCVType> RegType;
-  //记录已经重写的spill node
-  std::unordered_map<VirRegister *, RISCVMIR *> AlreadySpill;
   std::vector<RISCVBasicBlock*> topu;
   std::set<RISCVBasicBlock*> assist;
   RegisterList &reglist;
-  int LoopWeight = 1;
-  int livenessWeight = 1;
-  int DegreeWeight = 1;
-};
\ No newline at end of file
+  SpillRewriter rewriter;
+};
+
+/// @brief second-chance binpacking 线性扫描
+/// @note 区间带空洞, 每个物理寄存器是一个 bin, 区间只要不和 bin
+/// 里已有的区间相交就能放进去; 溢出的 vreg 在每个块里第一次用到时重新 load
+/// 进寄存器(second chance), 后面的 use 接着用这个值, 相当于在块边界和 call 处切开区间
+class LinearScan : public LiveInterval {
+  using Interval = RegAllocImpl::RegLiveInterval;
+  /// @brief 一个寄存器的生存区间, ranges 升序且左闭右开
+  struct LiveRange {
+    MOperand reg = nullptr;
+    std::vector<Interval> ranges;
+    double weight = 0;
+    PhyRegister *assigned = nullptr;
+    int start() const { return ranges.front().start; }
+    int end() const { return ranges.back().end; }
+    bool Overlap(const LiveRange &other) const;
+  };
+  RISCVFunction *m_func;
+  RegisterList &reglist;
+  // 下标是 RegNum 的编号; 构造时倒序加 range, 构造完再翻转
+  std::vector<LiveRange> lives;
+  // 每个物理寄存器里放着的 vreg 区间
+  std::unordered_map<PhyRegister *, std::vector<LiveRange *>> bins;
+  // mv 两端的寄存器, 分配时优先选同一个物理寄存器
+  std::unordered_map<MOperand, std::vector<MOperand>> hints;
+  std::unordered_set<PhyRegister *> callers;
+  std::unordered_set<VirRegister *> spilled;
+  // 只有一个定值且能重算的 vreg, 溢出时在 use 前重算
+  std::unordered_map<MOperand, RISCVMIR *> remat;
+  // 溢出改写时每个 use/def 单独用的临时寄存器, 不再溢出
+  std::unordered_set<MOperand> unspillable;
+  SpillRewriter rewriter;
+
+  void BuildIntervals();
+  bool Allocate();
+  bool Assign(LiveRange &cur);
+  void RewriteSpills();
+  void RewriteProgram();
+
+public:
+  LinearScan(RISCVFunction *func)
+      : LiveInterval(func), m_func(func),
+        reglist(RegisterList::GetPhyRegList()), rewriter(func) {}
+  void RunOnFunc();
+};
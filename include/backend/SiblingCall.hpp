@@ -0,0 +1,11 @@
+#pragma once
+#include "../../include/backend/BackendPass.hpp"
+#include "../../include/backend/RISCVMIR.hpp"
+
+/// @brief 寄存器分配之后把 call f; ret 改成 tail f, 省掉一次返回, 被调函数复用调用者让出来的栈
+/// @note 候选由 ISel 给出(RISCVFunction::GetSiblingCalls), 这里只确认 call 和 ret 之间只剩搬返回值的 mv
+class SiblingCall:public BackEndPass<RISCVFunction>{
+    bool Rewrite(RISCVMIR*);
+    public:
+    bool run(RISCVFunction*)override;
+};
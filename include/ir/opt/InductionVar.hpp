@@ -0,0 +1,38 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include "../../include/ir/opt/LoopInfo.hpp"
+#include <map>
+#include <vector>
+
+/// @brief 基本归纳变量 i=phi [init, preheader], [i+step, latch], step 为非零整数常量
+struct BasicIndVar{
+    Loop* loop=nullptr;
+    PhiInst* phi=nullptr;
+    Value* init=nullptr;
+    /// @brief latch 上流回 phi 的那条 add/sub
+    BinaryInst* next=nullptr;
+    int step=0;
+};
+
+/// @brief 找出每个循环 header 上的基本归纳变量
+/// @note 只认有 preheader 且只有一个 latch 的循环, 这样 phi 恰好两条入边
+class InductionVar:public _AnalysisBase{
+    Function* func;
+    _AnalysisManager& AM;
+    LoopInfo* loopinfo=nullptr;
+    int version=-1;
+    std::map<Loop*,std::vector<BasicIndVar>> indvars;
+    std::map<PhiInst*,BasicIndVar*> phi2iv;
+
+    void FindIndVars(Loop*);
+    public:
+    InductionVar(Function* _func,_AnalysisManager& _AM):func(_func),AM(_AM){}
+    void run()override;
+    bool IsStale()override;
+    std::vector<BasicIndVar>& GetIndVars(Loop*);
+    /// @brief val 是某个循环的基本归纳变量 phi 时返回它, 否则 nullptr
+    BasicIndVar* GetIndVar(Value* val);
+    /// @brief val 形如 iv, iv+c, c+iv, iv-c 时返回 true 并写回常数偏移 c
+    static bool GetOffset(BasicIndVar*,Value* val,int& offset);
+    void print();
+};
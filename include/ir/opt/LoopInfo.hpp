@@ -0,0 +1,71 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include "../../include/ir/opt/dominant.hpp"
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+class LoopInfo;
+
+/// @brief 一个自然循环, 同一个 header 的多条回边合并成一个循环
+class Loop{
+    friend class LoopInfo;
+    BasicBlock* header=nullptr;
+    BasicBlock* preheader=nullptr;
+    Loop* parent=nullptr;
+    int depth=1;
+    std::vector<Loop*> subloops;
+    /// @brief 按 DFS 前序排列, 第一个是 header
+    std::vector<BasicBlock*> blocks;
+    std::set<BasicBlock*> contain;
+    /// @brief latch: 有回边指向 header 的块
+    std::vector<BasicBlock*> latches;
+    /// @brief exiting: 循环内有后继在循环外的块; exit: 这些循环外的后继
+    std::vector<BasicBlock*> exiting,exits;
+    public:
+    BasicBlock* GetHeader(){return header;}
+    /// @brief 唯一的循环外前驱且它只有 header 一个后继, 否则为 nullptr
+    BasicBlock* GetPreheader(){return preheader;}
+    Loop* GetParent(){return parent;}
+    int GetDepth(){return depth;}
+    std::vector<Loop*>& GetSubLoops(){return subloops;}
+    std::vector<BasicBlock*>& GetBlocks(){return blocks;}
+    std::vector<BasicBlock*>& GetLatches(){return latches;}
+    std::vector<BasicBlock*>& GetExiting(){return exiting;}
+    std::vector<BasicBlock*>& GetExits(){return exits;}
+    bool Contains(BasicBlock* bb){return contain.find(bb)!=contain.end();}
+    bool Contains(Loop*);
+};
+
+/// @brief 基于支配树找回边, 构造循环嵌套森林, 并写回 BasicBlock::LoopDepth
+/// @note header 不支配 latch 的回边(不可规约的环)不认为是循环
+class LoopInfo:public _AnalysisBase{
+    Function* func;
+    _AnalysisManager& AM;
+    DominatorTree* dom=nullptr;
+    int version=-1;
+    std::vector<std::unique_ptr<Loop>> loops;
+    std::vector<Loop*> toplevel;
+    /// @brief 每个块所在的最内层循环
+    std::map<BasicBlock*,Loop*> innermost;
+
+    void FindLoops();
+    void BuildNest();
+    void CalcLoopEdges(Loop*);
+    public:
+    LoopInfo(Function* _func,_AnalysisManager& _AM):func(_func),AM(_AM){}
+    void run()override;
+    bool IsStale()override;
+    /// @brief 所有循环, 外层循环排在内层循环之前
+    std::vector<Loop*> GetLoops();
+    std::vector<Loop*>& GetTopLevelLoops(){return toplevel;}
+    /// @brief 块所在的最内层循环, 不在循环中返回 nullptr
+    Loop* GetLoopOf(BasicBlock*);
+    int GetLoopDepth(BasicBlock*);
+    bool IsLoopHeader(BasicBlock*);
+    /// @brief 给没有 preheader 的循环补一个, 返回新块; 已经有或者 header 是入口块时返回 nullptr
+    /// @note 会修改 CFG, 调用后支配树和循环信息都要重新 get
+    BasicBlock* InsertPreheader(Loop*);
+    void print();
+};
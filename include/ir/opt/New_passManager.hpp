@@ -2,4 +2,98 @@
 #include "../../lib/CFG.hpp"
 #include "../../lib/Singleton.hpp"
 #include <getopt.h>
-#include <memory>
\ No newline at end of file
+#include <memory>
+#include <map>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+class _AnalysisManager;
+
+/// @brief IR 层 pass 的基类, 和后端的 BackEndPass 一一对应
+/// @note run 返回 true 表示 IR 被修改, 对应函数的分析结果会被作废
+template<typename T>
+class _PassBase{
+    public:
+    virtual bool run(T*)=0;
+    virtual ~_PassBase()=default;
+};
+using ModulePass=_PassBase<Module>;
+using FunctionPass=_PassBase<Function>;
+
+/// @brief 分析结果的基类
+/// @note 派生类需提供 T(Function*,_AnalysisManager&) 的构造函数和 run()
+/// @note run() 可能被重复调用, 需要自己清空上一次的结果
+class _AnalysisBase{
+    public:
+    virtual void run()=0;
+    /// @brief 结果是否已经过时, 过时的结果在下一次 get 时原地重算
+    virtual bool IsStale(){return false;}
+    virtual ~_AnalysisBase()=default;
+};
+
+/// @brief 以函数为单位缓存分析结果, 同一个函数同一种分析只计算一次
+class _AnalysisManager{
+    using AnalysisPtr=std::unique_ptr<_AnalysisBase>;
+    std::map<Function*,std::map<std::type_index,AnalysisPtr>> cache;
+    public:
+    template<typename T>
+    T* get(Function* func){
+        auto& slot=cache[func][std::type_index(typeid(T))];
+        if(slot==nullptr){
+            auto tmp=new T(func,*this);
+            slot.reset(tmp);
+            tmp->run();
+        }
+        else if(slot->IsStale())
+            slot->run();
+        return static_cast<T*>(slot.get());
+    }
+    template<typename T>
+    bool cached(Function* func){
+        auto iter=cache.find(func);
+        if(iter==cache.end())return false;
+        return iter->second.find(std::type_index(typeid(T)))!=iter->second.end();
+    }
+    template<typename T>
+    void invalidate(Function* func){
+        auto iter=cache.find(func);
+        if(iter!=cache.end())
+            iter->second.erase(std::type_index(typeid(T)));
+    }
+    /// @brief 作废某个函数的全部分析结果
+    void invalidate(Function* func){cache.erase(func);}
+    void invalidate(){cache.clear();}
+};
+
+/// @brief 把 FunctionPass 包装成 ModulePass, 依次跑每个函数
+class FunctionPassAdaptor:public ModulePass{
+    std::unique_ptr<FunctionPass> pass;
+    _AnalysisManager& AM;
+    public:
+    FunctionPassAdaptor(FunctionPass* _pass,_AnalysisManager& _AM):pass(_pass),AM(_AM){}
+    bool run(Module*)override;
+};
+
+class PassManager{
+    public:
+    enum OptLevel{
+        O0,O1,O2
+    };
+    private:
+    OptLevel level;
+    _AnalysisManager AM;
+    std::vector<std::pair<std::string,std::unique_ptr<ModulePass>>> pipeline;
+    /// @brief 按优化等级注册默认的 pass 流水线
+    void InitPipeline();
+    public:
+    PassManager(OptLevel _level=O0);
+    void AddPass(std::string name,ModulePass* pass);
+    void AddPass(std::string name,FunctionPass* pass);
+    OptLevel GetOptLevel(){return level;}
+    _AnalysisManager& GetAnalysisManager(){return AM;}
+    /// @brief 依次运行流水线中的 pass, 返回 IR 是否被修改
+    bool run(Module*);
+    /// @brief 解析 -O0/-O1/-O2, 非法参数返回 O0
+    static OptLevel ParseOptLevel(const char*);
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include <set>
+#include <vector>
+
+/// @brief 标记-清除的死代码删除
+/// @note 根为终结指令, 有副作用的 call, 以及写到非本地 alloca 的 store; 沿操作数把用到的指令都标成 Alive, 其余删掉
+/// @note 只写不读且没有被传出去的 alloca, 往里的 store/memcpy 都是死的; 没有副作用的函数调用结果没人用也删
+/// @note 分支一律保留, 控制流的化简交给 SimplifyCFG
+class ADCE:public ModulePass{
+    _AnalysisManager& AM;
+    Module* module;
+    /// @brief 只被写过的 alloca
+    std::set<Value*> writeonly;
+
+    /// @brief 求出每个函数的 Function::HasSideEffect 并记到 Module::Side_Effect_Funcs
+    void CalcSideEffect();
+    bool LocalSideEffect(Function*);
+    bool RunOnFunction(Function*);
+    void CollectWriteOnly(Function*);
+    bool IsRoot(User*);
+    public:
+    ADCE(_AnalysisManager& _AM):AM(_AM){}
+    bool run(Module*)override;
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include "../../util/my_stl.hpp"
+#include <map>
+#include <set>
+#include <vector>
+
+/// @brief 基于 Lengauer-Tarjan 的支配树和支配边界分析
+/// @note 结点编号就是 DFS 前序编号, 0 号为入口块; 入口不可达的块不参与计算
+/// @note 缓存在 _AnalysisManager 中, SplitAt/InsertBlock 修改 CFG 后会自动重算
+class DominatorTree:public _AnalysisBase{
+    struct Node{
+        BasicBlock* bb=nullptr;
+        int father=-1;              //DFS 树上的父结点
+        int sdom=-1;                //半支配点
+        int idom=-1;                //直接支配点
+        int dfs_in=0,dfs_out=0;     //支配树上的进出时间戳, 用于 O(1) 的支配查询
+        std::vector<int> pred;
+        std::vector<int> bucket;    //sdom 为当前结点的结点
+        std::vector<BasicBlock*> children;
+        std::set<BasicBlock*> frontier;
+    };
+    struct DSU{
+        int father=-1;
+        int min_sdom=-1;            //到并查集根的路径上 sdom 最小的结点
+    };
+    Function* func;
+    int version=-1;
+    std::vector<Node> node;
+    std::vector<DSU> dsu;
+    std::map<BasicBlock*,int> index;
+    std::map<BasicBlock*,std::vector<BasicBlock*>> preds,succs;
+    std::vector<BasicBlock*> dfs_order;
+
+    void BuildCFG();
+    void DFS();
+    int Find(int);
+    void CalcIdom();
+    void CalcTimeStamp();
+    void CalcFrontier();
+    public:
+    DominatorTree(Function* _func,_AnalysisManager&):func(_func){}
+    void run()override;
+    bool IsStale()override;
+    bool IsReachable(BasicBlock*);
+    /// @brief a 是否支配 b, 包括 a==b; b 不可达时恒为 true
+    bool dominates(BasicBlock* a,BasicBlock* b);
+    bool StrictlyDominates(BasicBlock* a,BasicBlock* b){return a!=b&&dominates(a,b);}
+    /// @brief 入口块和不可达块返回 nullptr
+    BasicBlock* GetIdom(BasicBlock*);
+    std::vector<BasicBlock*>& GetChildren(BasicBlock*);
+    std::set<BasicBlock*>& GetFrontier(BasicBlock*);
+    /// @brief 去重后的前驱/后继, br %c, %x, %x 只算一条边
+    std::vector<BasicBlock*>& GetPreds(BasicBlock* bb){return preds[bb];}
+    std::vector<BasicBlock*>& GetSuccs(BasicBlock* bb){return succs[bb];}
+    /// @brief 可达块的 DFS 前序, 第一个元素为入口块
+    std::vector<BasicBlock*>& GetDFSOrder(){return dfs_order;}
+    void print();
+};
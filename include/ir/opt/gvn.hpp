@@ -0,0 +1,29 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include "../../include/ir/opt/dominant.hpp"
+#include "../../util/HashScope.hpp"
+#include <map>
+#include <vector>
+
+/// @brief 沿支配树的全局值编号, 消除 BinaryInst/GEP/Zext/类型转换的公共子表达式
+/// @note 进入一个块开一层作用域, 支配树上的祖先算出来的值在子树里都可见, 出块时撤销
+/// @note 块内顺带做冗余 load 消除: 同一地址没有被可能别名的 store/调用写过时复用上一次的值
+class GVN:public FunctionPass{
+    using ValueTable=HashScope<User*,User*,HashScopeAllocator,InstHashTool::InstHash,InstHashTool::InstSame>;
+    Function* func;
+    _AnalysisManager& AM;
+    DominatorTree* dom;
+    ValueTable table;
+    /// @brief 当前块内地址 -> 该地址上最近一次读/写的值
+    std::map<Value*,Value*> avail;
+
+    bool RunOnBlock(BasicBlock*);
+    bool CanNumber(User*);
+    bool EliminateLoad(LoadInst*);
+    void KillAlias(Value*);
+    public:
+    GVN(_AnalysisManager& _AM):AM(_AM){}
+    bool run(Function*)override;
+    /// @brief 两个地址是否可能指向同一个元素
+    static bool MayAlias(Value*,Value*);
+};
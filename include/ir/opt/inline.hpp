@@ -0,0 +1,54 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include "../../include/ir/opt/LoopInfo.hpp"
+#include <map>
+#include <set>
+#include <vector>
+
+/// @brief 内联的代价模型, 按被调函数的指令数和调用点的循环深度决定是否内联
+/// @note 指令数/栈帧大小来自 Function::GetInlineInfo, 每次判断前重算, 被调函数可能已经内联过别的函数
+class InlineCost{
+    public:
+    using InlineLevel=Function::InlineLevel;
+    /// @brief 循环外的调用点, 被调函数指令数不超过它才内联
+    static constexpr size_t Threshold=40;
+    /// @brief 调用点每深一层循环, 阈值放宽这么多, 最多算 MaxBonusDepth 层
+    static constexpr size_t LoopBonus=60;
+    static constexpr int MaxBonusDepth=3;
+    /// @brief 指令数不超过它的函数比调用本身的保存恢复还便宜, 总是内联
+    static constexpr size_t TinySize=8;
+    /// @brief 局部数组超过这个字节数的函数不内联, 免得调用者栈帧过大
+    static constexpr size_t MaxFrameSize=1024;
+    /// @brief 调用者内联后的指令数上限
+    static constexpr size_t MaxCallerSize=3000;
+    private:
+    std::set<Function*>& recursive;
+    std::map<Function*,int>& callsites;
+    public:
+    InlineCost(std::set<Function*>& _recursive,std::map<Function*,int>& _callsites)
+        :recursive(_recursive),callsites(_callsites){}
+    /// @brief 重新统计指令数和栈帧大小
+    static std::pair<size_t,size_t>& Refresh(Function*);
+    InlineLevel GetLevel(Function* callee);
+    bool ShouldInline(Function* caller,Function* callee,int depth);
+};
+
+/// @brief 自底向上的函数内联, 先处理被调函数, 内联进来的是已经展开过的函数体
+/// @note 递归函数(调用图上成环)和 main 不内联; 函数体内联后原函数保留
+class Inliner:public ModulePass{
+    _AnalysisManager& AM;
+    Module* module;
+    std::map<Function*,std::set<Function*>> callees;
+    std::map<Function*,int> callsites;
+    std::set<Function*> recursive;
+    /// @brief 被调函数在前的顺序
+    std::vector<Function*> order;
+
+    void BuildCallGraph();
+    void DFS(Function*,std::set<Function*>&,std::vector<Function*>&);
+    bool RunOnFunction(Function*,InlineCost&);
+    void InlineCall(CallInst*);
+    public:
+    Inliner(_AnalysisManager& _AM):AM(_AM){}
+    bool run(Module*)override;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include "../../include/ir/opt/dominant.hpp"
+#include "../../include/ir/opt/LoopInfo.hpp"
+#include <set>
+#include <vector>
+
+/// @brief 循环不变量外提, 把循环内的不变 GEP/二元运算/全局变量的 load 移到 preheader
+/// @note 从内层循环往外做, 内层提出来的指令落在外层循环里, 还能继续往外提
+/// @note 比较指令不提, 它们通常和条件跳转融合成一条 b 指令, 提出去反而要多占一个寄存器
+class LICM:public FunctionPass{
+    Function* func;
+    _AnalysisManager& AM;
+    DominatorTree* dom;
+    LoopInfo* loopinfo;
+    /// @brief 循环内可能被写的全局变量
+    std::set<Value*> clobbered;
+    /// @brief 循环内有经过未知指针的写, 全局数组都可能被改
+    bool clobber_arrays;
+    /// @brief 循环内调用了用户函数, 所有全局变量都可能被改
+    bool clobber_all;
+
+    bool InsertPreheaders();
+    bool RunOnLoop(Loop*);
+    void CalcClobber(Loop*);
+    void ClobberPointer(Value*);
+    bool IsInvariant(Loop*,Value*);
+    bool CanHoist(Loop*,User*);
+    bool CanHoistLoad(Loop*,LoadInst*);
+    /// @brief 所在块每次循环迭代都会执行到, 即支配所有 exiting 块
+    bool AlwaysExecuted(Loop*,BasicBlock*);
+    public:
+    LICM(_AnalysisManager& _AM):AM(_AM){}
+    bool run(Function*)override;
+    /// @brief 沿 GEP 链找到最初的基地址
+    static Value* GetBaseAddr(Value*);
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include "../../include/ir/opt/InductionVar.hpp"
+#include "../../include/ir/opt/LoopInfo.hpp"
+#include <map>
+#include <vector>
+
+/// @brief 循环强度削弱, 把 base[..][i+c][..] 这种每次都要 mulw 的地址计算改成每次加 stride 的指针 phi
+/// @note i 只用于寻址和循环退出判断时, 把退出判断换成指针比较并删掉 i
+/// @note 后端访存的地址必须是 GEP, 所以改写后的访问保留成 gep %p, c*stride, 在后端折成 offset(%p)
+class LoopStrengthReduce:public FunctionPass{
+    /// @brief 除了归纳变量那一维之外完全相同的一组 GEP 共用一个指针 phi
+    struct Group{
+        /// @brief GEP 的操作数, 归纳变量那一维为 nullptr
+        std::vector<Value*> key;
+        int pos=0;
+        /// @brief 归纳变量加一时指针走过多少个元素
+        int scale=1;
+        std::vector<std::pair<GetElementPtrInst*,int>> geps;
+        PhiInst* ptr=nullptr;
+    };
+    Function* func;
+    _AnalysisManager& AM;
+    InductionVar* indvar;
+    /// @brief 每个循环最多新建的指针 phi 数, 太多了寄存器压力顶不住
+    int MaxPtrPhis=6;
+
+    bool RunOnLoop(Loop*);
+    bool RunOnIndVar(BasicIndVar*,int& budget);
+    void CollectGEP(BasicIndVar*,Value*,int offset,std::vector<Group>&);
+    void Rewrite(BasicIndVar*,Group&);
+    bool ReplaceExitTest(BasicIndVar*,Group&);
+    static bool IsInvariant(Loop*,Value*);
+    public:
+    LoopStrengthReduce(_AnalysisManager& _AM):AM(_AM){}
+    bool run(Function*)override;
+};
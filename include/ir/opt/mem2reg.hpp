@@ -0,0 +1,28 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include "../../include/ir/opt/dominant.hpp"
+#include <map>
+#include <set>
+#include <vector>
+
+/// @brief 把只被 load/store 直接访问的标量 alloca 提升为 SSA 值
+/// @note 先在每个 alloca 定值块的迭代支配边界上插 phi, 再沿支配树前序重命名
+/// @note 数组和被当作指针传出去的 alloca 不处理
+class Mem2reg:public FunctionPass{
+    Function* func;
+    _AnalysisManager& AM;
+    DominatorTree* dom;
+    std::vector<AllocaInst*> allocas;
+    std::map<AllocaInst*,int> alloca_index;
+    /// @brief 本 pass 插入的 phi 对应哪个 alloca
+    std::map<PhiInst*,int> phi2alloca;
+
+    bool RemoveUnreachable();
+    bool Promotable(AllocaInst*);
+    void InsertPhi();
+    void Rename(BasicBlock*,std::vector<std::vector<Value*>>&);
+    void RemoveDeadPhi();
+    public:
+    Mem2reg(_AnalysisManager& _AM):AM(_AM){}
+    bool run(Function*)override;
+};
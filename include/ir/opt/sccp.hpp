@@ -0,0 +1,43 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include <map>
+#include <set>
+#include <vector>
+
+/// @brief 稀疏条件常量传播(Wegman-Zadeck), 只沿可执行的边传播常量
+/// @note 折叠 BinaryInst/Zext/FPTSI/SITFP/Phi, 条件为常量的 br 改成无条件跳转, 再删掉不可达的块
+class SCCP:public FunctionPass{
+    struct Lattice{
+        enum State{
+            Undef,      //还没算出来
+            Const,
+            Overdefined
+        }state=Undef;
+        Value* val=nullptr;
+    };
+    Function* func;
+    _AnalysisManager& AM;
+    std::map<Value*,Lattice> value;
+    std::set<BasicBlock*> executable;
+    std::set<std::pair<BasicBlock*,BasicBlock*>> edges;
+    std::vector<BasicBlock*> blockworklist;
+    std::vector<User*> instworklist;
+
+    Lattice GetLattice(Value*);
+    void MarkOverdefined(User*);
+    void MarkConst(User*,Value*);
+    void MarkEdge(BasicBlock* from,BasicBlock* to);
+    void Visit(User*);
+    void VisitPhi(PhiInst*);
+    void VisitBranch(User*);
+    void Solve();
+    /// @brief 条件一直是 Undef 的 br 两边都当作可达, 返回是否有新的边
+    bool ResolveUndefBranch();
+    /// @brief 操作数全是常量时算出结果, 算不了(除零等)返回 nullptr
+    Value* Fold(User*);
+    bool Rewrite();
+    bool RemoveDeadBlocks();
+    public:
+    SCCP(_AnalysisManager& _AM):AM(_AM){}
+    bool run(Function*)override;
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include <map>
+#include <vector>
+
+/// @brief 控制流化简: 删不可达块, 折叠条件确定或两边相同的 br, 跳过只有一条 br 的空块, 合并单前驱单后继的直线块
+/// @note 会去掉循环的 preheader, 依赖 preheader 的 pass 要放在后面时自己补(LICM::InsertPreheaders)
+class SimplifyCFG:public FunctionPass{
+    Function* func;
+    _AnalysisManager& AM;
+    /// @brief 每个块不重复的前驱
+    std::map<BasicBlock*,std::vector<BasicBlock*>> preds;
+
+    void BuildPreds();
+    bool FoldBranches();
+    bool RemoveForwardingBlocks();
+    bool MergeBlocks();
+    public:
+    SimplifyCFG(_AnalysisManager& _AM):AM(_AM){}
+    bool run(Function*)override;
+    /// @note Succ_Block 不随 pass 更新, 后继从终结指令取
+    static std::vector<BasicBlock*> GetSuccs(BasicBlock*);
+    /// @brief 从 entry 出发标 BasicBlock::reachable, 删掉没标上的块
+    static bool RemoveUnreachable(Function*);
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include <vector>
+
+/// @brief 尾递归消除, 把 ret f(...) 改成跳回函数开头的循环, 形参变成入口块里的 phi
+/// @note 也处理 ret x+f(...) / ret x*f(...) 这种整数加乘的累加形式, 多一个累加值的 phi, 其余 ret 改成返回累加值和原返回值的运算
+/// @note 实参里有本函数 alloca 出来的地址时不做, 循环里下一轮会复用同一块栈空间
+class TailRecElim:public FunctionPass{
+    /// @brief 一处尾调用: call, 紧跟着的 ret, 累加形式时中间的 BinaryInst
+    struct Site{
+        CallInst* call;
+        BinaryInst* accum;
+        RetInst* ret;
+    };
+    Function* func;
+    _AnalysisManager& AM;
+
+    bool IsSelfCall(Value*);
+    bool FindSite(BasicBlock*,Site&);
+    public:
+    TailRecElim(_AnalysisManager& _AM):AM(_AM){}
+    bool run(Function*)override;
+    /// @brief 实参是不是本函数栈上的地址
+    static bool PointsToFrame(Value*);
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include "../../include/ir/opt/New_passManager.hpp"
+#include "../../include/ir/opt/InductionVar.hpp"
+#include "../../include/ir/opt/LoopInfo.hpp"
+#include <unordered_map>
+#include <vector>
+
+/// @brief 循环展开, 只处理 while 形状的最内层循环: header 里只有 phi, 一条 iv 和循环不变量的比较, 以及条件跳转
+/// @note 次数是小常数时完全展开: preheader 直接接上 n 份循环体, 原来的循环留在后面跑 0 次, 交给 SCCP/ADCE 删
+/// @note 否则按 factor 部分展开: 新建一个每次跑 factor 份循环体的主循环, 原来的循环原封不动地当余数循环
+class LoopUnroll:public FunctionPass{
+    /// @brief 一个可以展开的循环
+    struct Candidate{
+        Loop* loop=nullptr;
+        BasicIndVar* iv=nullptr;
+        BinaryInst* cmp=nullptr;
+        /// @brief 规整成 iv pred bound 的形式
+        BinaryInst::Operation pred;
+        Value* bound=nullptr;
+        /// @brief header 之外的循环块, 第一个是循环体入口
+        std::vector<BasicBlock*> body;
+        int size=0;
+    };
+    Function* func;
+    _AnalysisManager& AM;
+    InductionVar* indvar;
+    /// @brief 完全展开后循环体的总指令数上限, 以及最多展开的次数
+    int FullBudget;
+    int MaxFullTrip;
+    /// @brief 部分展开后主循环体的指令数上限, 以及最大展开因子
+    int PartialBudget;
+    int MaxFactor;
+
+    bool Analyze(Loop*,Candidate&);
+    /// @brief 常数次数时返回迭代次数, 否则返回 -1
+    int GetTripCount(Candidate&);
+    /// @brief 把循环体复制 count 份首尾相接, header 的 phi 在第一份里取 init 的值
+    /// @return 最后一份的 latch; 每个 header phi 在 count 份之后的值写回 init
+    BasicBlock* CloneBody(Candidate&,int count,std::unordered_map<PhiInst*,Value*>& init,BasicBlock* before,BasicBlock*& entry);
+    void FullUnroll(Candidate&,int trip);
+    bool PartialUnroll(Candidate&,int factor);
+    /// @brief 把 phi 来自 from 的那一项改成 [val, to]
+    static void ReplaceIncoming(PhiInst*,BasicBlock* from,Value* val,BasicBlock* to);
+    public:
+    LoopUnroll(_AnalysisManager& _AM,int _FullBudget=256,int _MaxFullTrip=32,int _PartialBudget=64,int _MaxFactor=4)
+        :AM(_AM),FullBudget(_FullBudget),MaxFullTrip(_MaxFullTrip),PartialBudget(_PartialBudget),MaxFactor(_MaxFactor){}
+    bool run(Function*)override;
+};
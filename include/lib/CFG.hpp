@@ -56,6 +56,7 @@ class Variable:public User
     bool isGlobal()final;
     /// @warning the type should be the inner type like alloca  
     Variable(UsageTag,Type*,std::string);
+    Variable* clone(std::unordered_map<Operand,Operand>&)override;
     void print();
     inline Value* GetInitializer(){
         if(uselist.empty()){
@@ -227,7 +228,7 @@ public:
   Value* GetVal(int index);
   void ModifyBlock(BasicBlock* Old,BasicBlock* New);
   std::vector<BasicBlock*> Blocks;
-  int oprandNum;
+  int oprandNum=0;
   bool IsGetIncomings=false;
 };
 class BasicBlock:public Value,public mylist<BasicBlock,User>,public list_node<Function,BasicBlock>
@@ -310,6 +311,10 @@ class Function:public Value,public mylist<Function,BasicBlock>
     void InsertBlock(BasicBlock* curr,BasicBlock* insert);
     void init_visited_block();
     void init_reach_block();
+    /// @brief 每次修改 CFG 都要调用, 支配树等分析据此判断是否需要重算
+    void CFGChanged(){cfg_version++;}
+    int GetCFGVersion(){return cfg_version;}
+    int cfg_version=0;
     int bb_num=0;
     bool HasSideEffect = false;
 };
@@ -328,6 +333,7 @@ class Module:public SymbolTable
     void PushVariable(Variable* ptr);
     std::vector<FunctionPtr>& GetFuncTion();
     std::vector<GlobalVariblePtr>& GetGlobalVariable();
+    /// @brief 打印整个模块的 IR, 用到的内建函数先按调用处的实参类型打 declare
     void Test();
     void EraseFunction(Function* func);
     Function* GetMainFunction();
@@ -48,6 +48,8 @@ class list_node
         if(this->next!=nullptr)this->next->prev=this->prev;
         fat->size--;
         fat=nullptr;
+        this->prev=nullptr;
+        this->next=nullptr;
     }
     virtual derived_mylist* GetParent(){return this->fat;};
 
@@ -105,8 +107,8 @@ class mylist
                 data->next=ptr;
                 ptr->prev=data;
                 data->prev->next=data;
+                ptr->fat->size++;
             }
-            ptr->fat->size++;
             return iterator(data);
         }
         iterator insert_after(derived_list_node* data){
@@ -119,8 +121,8 @@ class mylist
                 data->prev=ptr;
                 ptr->next=data;
                 data->next->prev=data;
+                ptr->fat->size++;
             }
-            ptr->fat->size++;
             return iterator(data);
         }
 
@@ -173,6 +175,7 @@ class mylist
 
     void push_back(derived_list_node* data){
         data->SetParent(dynamic_cast<derived_mylist*>(this));
+        data->next=nullptr;
         if(this->head==nullptr){
             this->head=data;
             this->tail=data;
@@ -186,6 +189,7 @@ class mylist
     }
     void push_front(derived_list_node* data){
         data->SetParent(dynamic_cast<derived_mylist*>(this));
+        data->prev=nullptr;
         if(this->head==nullptr){
             this->head=data;
             this->tail=data;
@@ -0,0 +1,87 @@
+#include "../../include/ir/opt/InductionVar.hpp"
+
+bool InductionVar::IsStale(){
+    return version!=func->GetCFGVersion();
+}
+
+void InductionVar::run(){
+    version=func->GetCFGVersion();
+    indvars.clear();
+    phi2iv.clear();
+    loopinfo=AM.get<LoopInfo>(func);
+    for(auto loop:loopinfo->GetLoops())
+        FindIndVars(loop);
+    for(auto& [loop,vec]:indvars)
+        for(auto& iv:vec)
+            phi2iv[iv.phi]=&iv;
+}
+
+void InductionVar::FindIndVars(Loop* loop){
+    auto& vec=indvars[loop];
+    auto preheader=loop->GetPreheader();
+    if(preheader==nullptr||loop->GetLatches().size()!=1)
+        return;
+    auto latch=loop->GetLatches()[0];
+    for(auto inst:*loop->GetHeader()){
+        auto phi=dynamic_cast<PhiInst*>(inst);
+        if(phi==nullptr)break;
+        if(phi->GetTypeEnum()!=IR_Value_INT||phi->PhiRecord.size()!=2)
+            continue;
+        auto init=phi->ReturnValIn(preheader);
+        auto next=dynamic_cast<BinaryInst*>(phi->ReturnValIn(latch));
+        if(init==nullptr||next==nullptr)
+            continue;
+        BasicIndVar iv;
+        iv.loop=loop;
+        iv.phi=phi;
+        iv.init=init;
+        iv.next=next;
+        if(!GetOffset(&iv,next,iv.step)||iv.step==0)
+            continue;
+        vec.push_back(iv);
+    }
+}
+
+bool InductionVar::GetOffset(BasicIndVar* iv,Value* val,int& offset){
+    if(val==iv->phi){
+        offset=0;
+        return true;
+    }
+    auto bin=dynamic_cast<BinaryInst*>(val);
+    if(bin==nullptr)
+        return false;
+    auto op=bin->getopration();
+    auto lhs=bin->GetOperand(0),rhs=bin->GetOperand(1);
+    if(op==BinaryInst::Op_Add){
+        if(lhs!=iv->phi)
+            std::swap(lhs,rhs);
+    }
+    else if(op!=BinaryInst::Op_Sub)
+        return false;
+    auto cint=dynamic_cast<ConstIRInt*>(rhs);
+    if(lhs!=iv->phi||cint==nullptr)
+        return false;
+    offset=(op==BinaryInst::Op_Add)?cint->GetVal():-cint->GetVal();
+    return true;
+}
+
+std::vector<BasicIndVar>& InductionVar::GetIndVars(Loop* loop){
+    return indvars[loop];
+}
+
+BasicIndVar* InductionVar::GetIndVar(Value* val){
+    auto phi=dynamic_cast<PhiInst*>(val);
+    if(phi==nullptr)
+        return nullptr;
+    auto iter=phi2iv.find(phi);
+    if(iter==phi2iv.end())
+        return nullptr;
+    return iter->second;
+}
+
+void InductionVar::print(){
+    for(auto loop:loopinfo->GetLoops())
+        for(auto& iv:indvars[loop])
+            std::cerr<<"loop "<<loop->GetHeader()->GetName()<<": "<<iv.phi->GetName()
+                     <<" = {"<<iv.init->GetName()<<", +, "<<iv.step<<"}\n";
+}
@@ -0,0 +1,206 @@
+#include "../../include/ir/opt/LoopInfo.hpp"
+#include <algorithm>
+
+bool Loop::Contains(Loop* loop){
+    while(loop!=nullptr&&loop->depth>depth)
+        loop=loop->parent;
+    return loop==this;
+}
+
+bool LoopInfo::IsStale(){
+    return version!=func->GetCFGVersion();
+}
+
+void LoopInfo::run(){
+    version=func->GetCFGVersion();
+    loops.clear();
+    toplevel.clear();
+    innermost.clear();
+    dom=AM.get<DominatorTree>(func);
+    FindLoops();
+    BuildNest();
+    for(auto bb:*func)
+        bb->LoopDepth=GetLoopDepth(bb);
+}
+
+/// @brief 按 DFS 前序找回边 latch->header, 再从 latch 逆着 CFG 走到 header 收集循环体
+void LoopInfo::FindLoops(){
+    std::map<BasicBlock*,int> order;
+    auto& dfs=dom->GetDFSOrder();
+    for(int i=0;i<dfs.size();i++)
+        order[dfs[i]]=i;
+    for(auto header:dfs){
+        std::vector<BasicBlock*> latches;
+        for(auto pred:dom->GetPreds(header))
+            if(dom->IsReachable(pred)&&dom->dominates(header,pred))
+                latches.push_back(pred);
+        if(latches.empty())continue;
+
+        auto loop=new Loop();
+        loops.emplace_back(loop);
+        loop->header=header;
+        loop->latches=latches;
+        loop->contain.insert(header);
+        std::vector<BasicBlock*> worklist;
+        for(auto latch:latches)
+            if(loop->contain.insert(latch).second)
+                worklist.push_back(latch);
+        while(!worklist.empty()){
+            auto bb=worklist.back();
+            worklist.pop_back();
+            for(auto pred:dom->GetPreds(bb))
+                if(dom->IsReachable(pred)&&loop->contain.insert(pred).second)
+                    worklist.push_back(pred);
+        }
+        loop->blocks.assign(loop->contain.begin(),loop->contain.end());
+        std::sort(loop->blocks.begin(),loop->blocks.end(),[&](BasicBlock* a,BasicBlock* b){
+            return order[a]<order[b];
+        });
+        CalcLoopEdges(loop);
+    }
+}
+
+void LoopInfo::CalcLoopEdges(Loop* loop){
+    std::set<BasicBlock*> exits;
+    for(auto bb:loop->blocks){
+        bool is_exiting=false;
+        for(auto succ:dom->GetSuccs(bb)){
+            if(loop->Contains(succ))continue;
+            is_exiting=true;
+            if(exits.insert(succ).second)
+                loop->exits.push_back(succ);
+        }
+        if(is_exiting)
+            loop->exiting.push_back(bb);
+    }
+    std::vector<BasicBlock*> outside;
+    for(auto pred:dom->GetPreds(loop->header))
+        if(!loop->Contains(pred)&&dom->IsReachable(pred))
+            outside.push_back(pred);
+    if(outside.size()==1&&dom->GetSuccs(outside[0]).size()==1)
+        loop->preheader=outside[0];
+}
+
+/// @brief 不同 header 的自然循环要么不相交要么嵌套, 父循环就是包含自己 header 的最小的另一个循环
+void LoopInfo::BuildNest(){
+    for(auto& loop:loops){
+        Loop* parent=nullptr;
+        for(auto& other:loops){
+            if(other.get()==loop.get()||!other->Contains(loop->header))
+                continue;
+            if(other->blocks.size()<=loop->blocks.size())
+                continue;
+            if(parent==nullptr||other->blocks.size()<parent->blocks.size())
+                parent=other.get();
+        }
+        loop->parent=parent;
+    }
+    for(auto& loop:loops){
+        if(loop->parent==nullptr)
+            toplevel.push_back(loop.get());
+        else
+            loop->parent->subloops.push_back(loop.get());
+    }
+    std::vector<Loop*> worklist(toplevel.begin(),toplevel.end());
+    while(!worklist.empty()){
+        auto loop=worklist.back();
+        worklist.pop_back();
+        loop->depth=(loop->parent==nullptr)?1:loop->parent->depth+1;
+        for(auto bb:loop->blocks)
+            innermost[bb]=loop;
+        for(auto sub:loop->subloops)
+            worklist.push_back(sub);
+    }
+}
+
+std::vector<Loop*> LoopInfo::GetLoops(){
+    std::vector<Loop*> res;
+    std::vector<Loop*> worklist(toplevel.rbegin(),toplevel.rend());
+    while(!worklist.empty()){
+        auto loop=worklist.back();
+        worklist.pop_back();
+        res.push_back(loop);
+        for(auto iter=loop->subloops.rbegin();iter!=loop->subloops.rend();++iter)
+            worklist.push_back(*iter);
+    }
+    return res;
+}
+
+Loop* LoopInfo::GetLoopOf(BasicBlock* bb){
+    auto iter=innermost.find(bb);
+    if(iter==innermost.end())
+        return nullptr;
+    return iter->second;
+}
+
+int LoopInfo::GetLoopDepth(BasicBlock* bb){
+    auto loop=GetLoopOf(bb);
+    return loop==nullptr?0:loop->depth;
+}
+
+bool LoopInfo::IsLoopHeader(BasicBlock* bb){
+    auto loop=GetLoopOf(bb);
+    return loop!=nullptr&&loop->header==bb;
+}
+
+/// @brief 循环外前驱全部改跳到新块, header 的 phi 中这些前驱的入边合并成新块的一条入边
+BasicBlock* LoopInfo::InsertPreheader(Loop* loop){
+    if(loop->preheader!=nullptr)
+        return nullptr;
+    auto header=loop->header;
+    std::vector<BasicBlock*> outside;
+    for(auto pred:dom->GetPreds(header))
+        if(!loop->Contains(pred)&&dom->IsReachable(pred))
+            outside.push_back(pred);
+    if(outside.empty())
+        return nullptr;
+
+    auto preheader=new BasicBlock();
+    mylist<Function,BasicBlock>::iterator(header).insert_before(preheader);
+    preheader->GenerateUnCondInst(header);
+    for(auto pred:outside){
+        auto term=pred->back();
+        for(int i=0;i<term->Getuselist().size();i++)
+            if(term->GetOperand(i)==header)
+                term->RSUW(i,preheader);
+    }
+
+    for(auto inst:*header){
+        auto phi=dynamic_cast<PhiInst*>(inst);
+        if(phi==nullptr)break;
+        std::vector<int> from_outside;
+        for(auto& [idx,rec]:phi->PhiRecord)
+            if(std::find(outside.begin(),outside.end(),rec.second)!=outside.end())
+                from_outside.push_back(idx);
+        if(from_outside.empty())continue;
+        if(from_outside.size()==1){
+            phi->ModifyBlock(phi->PhiRecord[from_outside[0]].second,preheader);
+            continue;
+        }
+        Value* income=phi->PhiRecord[from_outside[0]].first;
+        bool same=true;
+        for(auto idx:from_outside)
+            same&=(phi->PhiRecord[idx].first==income);
+        if(!same){
+            auto newphi=PhiInst::NewPhiNode(preheader->front(),preheader,phi->GetType());
+            for(auto idx:from_outside)
+                newphi->updateIncoming(phi->PhiRecord[idx].first,phi->PhiRecord[idx].second);
+            income=newphi;
+        }
+        for(auto idx:from_outside)
+            phi->Del_Incomes(idx);
+        phi->FormatPhi();
+        phi->updateIncoming(income,preheader);
+    }
+    func->CFGChanged();
+    return preheader;
+}
+
+void LoopInfo::print(){
+    for(auto loop:GetLoops()){
+        std::cerr<<std::string(2*loop->depth,' ')<<"loop "<<loop->header->GetName()<<" depth "<<loop->depth<<":";
+        for(auto bb:loop->blocks)
+            std::cerr<<" "<<bb->GetName();
+        std::cerr<<", preheader "<<(loop->preheader?loop->preheader->GetName():"-")<<'\n';
+    }
+}
@@ -0,0 +1,153 @@
+#include "../../include/ir/opt/adce.hpp"
+#include "../../include/ir/opt/licm.hpp"
+#include "../../include/ir/opt/simplifycfg.hpp"
+#include <functional>
+
+bool ADCE::run(Module* m){
+    module=m;
+    CalcSideEffect();
+    bool modified=false;
+    for(auto& func:module->GetFuncTion()){
+        if(RunOnFunction(func.get())){
+            AM.invalidate(func.get());
+            modified=true;
+        }
+    }
+    return modified;
+}
+
+/// @brief memcpy/memset, 只写第一个参数指向的内存
+static bool IsMemcpy(CallInst* call){
+    auto name=call->GetOperand(0)->GetName();
+    return name=="llvm.memcpy.p0.p0.i32"||name=="llvm.memset.p0.i32";
+}
+
+/// @brief 不看调用别的用户函数, 自己有没有写非本地的内存或者做 IO
+bool ADCE::LocalSideEffect(Function* func){
+    for(auto bb:*func)
+        for(auto inst:*bb){
+            if(auto store=dynamic_cast<StoreInst*>(inst)){
+                if(dynamic_cast<AllocaInst*>(LICM::GetBaseAddr(store->GetOperand(1)))==nullptr)
+                    return true;
+            }
+            else if(auto call=dynamic_cast<CallInst*>(inst)){
+                if(dynamic_cast<Function*>(call->GetOperand(0)))
+                    continue;
+                if(IsMemcpy(call)&&dynamic_cast<AllocaInst*>(LICM::GetBaseAddr(call->GetOperand(1))))
+                    continue;
+                if(call->HasSideEffect())
+                    return true;
+            }
+        }
+    return false;
+}
+
+void ADCE::CalcSideEffect(){
+    module->Side_Effect_Funcs.clear();
+    for(auto& func:module->GetFuncTion())
+        func->HasSideEffect=LocalSideEffect(func.get());
+    // 调用了有副作用的函数的函数也有副作用, 迭代到不动点
+    bool changed=true;
+    while(changed){
+        changed=false;
+        for(auto& func:module->GetFuncTion()){
+            if(func->HasSideEffect)continue;
+            for(auto bb:*func){
+                for(auto inst:*bb)
+                    if(auto call=dynamic_cast<CallInst*>(inst))
+                        if(auto callee=dynamic_cast<Function*>(call->GetOperand(0)))
+                            if(callee->HasSideEffect){
+                                func->HasSideEffect=true;
+                                break;
+                            }
+                if(func->HasSideEffect)break;
+            }
+            changed|=func->HasSideEffect;
+        }
+    }
+    for(auto& func:module->GetFuncTion())
+        if(func->HasSideEffect)
+            module->Side_Effect_Funcs.insert(func.get());
+}
+
+/// @brief 沿 GEP 看 alloca 的所有使用, 只作为 store/memcpy 的目的地址出现时才算只写
+void ADCE::CollectWriteOnly(Function* func){
+    writeonly.clear();
+    std::function<bool(Value*)> OnlyWritten=[&](Value* ptr){
+        for(auto use:ptr->GetUserlist()){
+            auto user=use->GetUser();
+            if(dynamic_cast<GetElementPtrInst*>(user)){
+                if(user->GetOperand(0)!=ptr||!OnlyWritten(user))
+                    return false;
+            }
+            else if(dynamic_cast<StoreInst*>(user)){
+                if(user->GetOperand(0)==ptr)
+                    return false;
+            }
+            else if(auto call=dynamic_cast<CallInst*>(user)){
+                if(!IsMemcpy(call)||call->GetOperand(1)!=ptr)
+                    return false;
+            }
+            else
+                return false;
+        }
+        return true;
+    };
+    for(auto bb:*func)
+        for(auto inst:*bb)
+            if(auto alloca=dynamic_cast<AllocaInst*>(inst))
+                if(OnlyWritten(alloca))
+                    writeonly.insert(alloca);
+}
+
+bool ADCE::IsRoot(User* inst){
+    if(inst->IsTerminateInst())
+        return true;
+    if(auto store=dynamic_cast<StoreInst*>(inst))
+        return writeonly.find(LICM::GetBaseAddr(store->GetOperand(1)))==writeonly.end();
+    if(auto call=dynamic_cast<CallInst*>(inst)){
+        if(IsMemcpy(call))
+            return writeonly.find(LICM::GetBaseAddr(call->GetOperand(1)))==writeonly.end();
+        return call->HasSideEffect();
+    }
+    return false;
+}
+
+bool ADCE::RunOnFunction(Function* func){
+    bool modified=SimplifyCFG::RemoveUnreachable(func);
+    CollectWriteOnly(func);
+
+    std::vector<User*> worklist;
+    for(auto bb:*func)
+        for(auto inst:*bb){
+            inst->Alive=IsRoot(inst);
+            if(inst->Alive)
+                worklist.push_back(inst);
+        }
+    while(!worklist.empty()){
+        auto inst=worklist.back();
+        worklist.pop_back();
+        for(auto& use:inst->Getuselist()){
+            auto def=dynamic_cast<User*>(use->GetValue());
+            if(def==nullptr||def->GetParent()==nullptr||def->Alive)
+                continue;
+            def->Alive=true;
+            worklist.push_back(def);
+        }
+    }
+
+    std::vector<User*> dead;
+    for(auto bb:*func)
+        for(auto inst:*bb)
+            if(!inst->Alive)
+                dead.push_back(inst);
+    if(dead.empty())
+        return modified;
+    // 死指令只会被死指令用到, 先断开再删
+    for(auto inst:dead)
+        if(!inst->GetUserlist().is_empty())
+            inst->RAUW(UndefValue::get(inst->GetType()));
+    for(auto inst:dead)
+        delete inst;
+    return true;
+}
@@ -0,0 +1,201 @@
+#include "../../include/ir/opt/dominant.hpp"
+
+bool DominatorTree::IsStale(){
+    return version!=func->GetCFGVersion();
+}
+
+void DominatorTree::run(){
+    version=func->GetCFGVersion();
+    node.clear();
+    dsu.clear();
+    index.clear();
+    preds.clear();
+    succs.clear();
+    dfs_order.clear();
+    BuildCFG();
+    DFS();
+    CalcIdom();
+    CalcTimeStamp();
+    CalcFrontier();
+}
+
+void DominatorTree::BuildCFG(){
+    for(auto bb:*func){
+        auto term=bb->back();
+        if(term==nullptr)continue;
+        if(term->IsCondInst()){
+            for(int i=1;i<3;i++){
+                auto succ=term->GetOperand(i)->as<BasicBlock>();
+                if(i==2&&succ==term->GetOperand(1))break;
+                succs[bb].push_back(succ);
+                preds[succ].push_back(bb);
+            }
+        }
+        else if(term->IsUncondInst()){
+            auto succ=term->GetOperand(0)->as<BasicBlock>();
+            succs[bb].push_back(succ);
+            preds[succ].push_back(bb);
+        }
+    }
+}
+
+/// @brief 非递归 DFS, 给可达块按前序编号并记录 DFS 树父结点
+void DominatorTree::DFS(){
+    std::vector<std::pair<BasicBlock*,int>> stack;
+    auto visit=[&](BasicBlock* bb,int father){
+        index[bb]=node.size();
+        node.emplace_back();
+        node.back().bb=bb;
+        node.back().father=father;
+        dfs_order.push_back(bb);
+        stack.emplace_back(bb,0);
+    };
+    visit(func->front(),-1);
+    while(!stack.empty()){
+        auto& [bb,idx]=stack.back();
+        auto& vec=succs[bb];
+        if(idx<vec.size()){
+            auto succ=vec[idx++];
+            if(index.find(succ)==index.end())
+                visit(succ,index[bb]);
+        }
+        else
+            stack.pop_back();
+    }
+    for(int i=0;i<node.size();i++){
+        for(auto pred:preds[node[i].bb]){
+            auto iter=index.find(pred);
+            if(iter!=index.end())
+                node[i].pred.push_back(iter->second);
+        }
+    }
+}
+
+/// @brief 带路径压缩的并查集查询, 返回值为并查集的根, 同时维护 MIN_SDOM
+/// @note 根结点本身不参与 MIN_SDOM 的比较
+int DominatorTree::Find(int x){
+    int fa=dsu[x].father;
+    if(fa==-1)return x;
+    if(dsu[fa].father==-1)return fa;
+    int root=Find(fa);
+    if(SDOM(MIN_SDOM(fa))<SDOM(MIN_SDOM(x)))
+        MIN_SDOM(x)=MIN_SDOM(fa);
+    dsu[x].father=root;
+    return root;
+}
+
+void DominatorTree::CalcIdom(){
+    int n=node.size();
+    dsu.resize(n);
+    for(int i=0;i<n;i++){
+        SDOM(i)=i;
+        MIN_SDOM(i)=i;
+    }
+    // 逆前序处理, 处理完的结点挂到 DFS 树父结点上
+    for(int w=n-1;w>0;w--){
+        for(auto v:node[w].pred){
+            int u=v;
+            if(v>w){
+                Find(v);
+                u=MIN_SDOM(v);
+            }
+            if(SDOM(u)<SDOM(w))
+                SDOM(w)=SDOM(u);
+        }
+        node[SDOM(w)].bucket.push_back(w);
+        int fa=node[w].father;
+        dsu[w].father=fa;
+        for(auto v:node[fa].bucket){
+            Find(v);
+            int u=MIN_SDOM(v);
+            IDOM(v)=(SDOM(u)<SDOM(v))?u:fa;
+        }
+        node[fa].bucket.clear();
+    }
+    for(int w=1;w<n;w++)
+        if(IDOM(w)!=SDOM(w))
+            IDOM(w)=IDOM(IDOM(w));
+    for(int w=1;w<n;w++)
+        node[IDOM(w)].children.push_back(node[w].bb);
+}
+
+void DominatorTree::CalcTimeStamp(){
+    int clock=0;
+    std::vector<std::pair<int,int>> stack{{0,0}};
+    node[0].dfs_in=clock++;
+    while(!stack.empty()){
+        auto& [x,idx]=stack.back();
+        if(idx<node[x].children.size()){
+            int child=index[node[x].children[idx++]];
+            node[child].dfs_in=clock++;
+            stack.emplace_back(child,0);
+        }
+        else{
+            node[x].dfs_out=clock++;
+            stack.pop_back();
+        }
+    }
+}
+
+/// @brief Cooper 的做法: 从汇合点的每个前驱沿支配树往上走到 idom 为止
+void DominatorTree::CalcFrontier(){
+    for(int i=1;i<node.size();i++){
+        if(node[i].pred.size()<2)continue;
+        for(auto runner:node[i].pred){
+            while(runner!=IDOM(i)){
+                node[runner].frontier.insert(node[i].bb);
+                runner=IDOM(runner);
+            }
+        }
+    }
+}
+
+bool DominatorTree::IsReachable(BasicBlock* bb){
+    return index.find(bb)!=index.end();
+}
+
+bool DominatorTree::dominates(BasicBlock* a,BasicBlock* b){
+    auto iter_b=index.find(b);
+    if(iter_b==index.end())
+        return true;
+    auto iter_a=index.find(a);
+    if(iter_a==index.end())
+        return false;
+    auto& na=node[iter_a->second];
+    auto& nb=node[iter_b->second];
+    return na.dfs_in<=nb.dfs_in&&nb.dfs_out<=na.dfs_out;
+}
+
+BasicBlock* DominatorTree::GetIdom(BasicBlock* bb){
+    auto iter=index.find(bb);
+    if(iter==index.end()||iter->second==0)
+        return nullptr;
+    return node[IDOM(iter->second)].bb;
+}
+
+std::vector<BasicBlock*>& DominatorTree::GetChildren(BasicBlock* bb){
+    static std::vector<BasicBlock*> empty;
+    auto iter=index.find(bb);
+    if(iter==index.end())
+        return empty;
+    return node[iter->second].children;
+}
+
+std::set<BasicBlock*>& DominatorTree::GetFrontier(BasicBlock* bb){
+    static std::set<BasicBlock*> empty;
+    auto iter=index.find(bb);
+    if(iter==index.end())
+        return empty;
+    return node[iter->second].frontier;
+}
+
+void DominatorTree::print(){
+    for(auto bb:dfs_order){
+        std::cerr<<bb->GetName()<<": idom ";
+        auto idom=GetIdom(bb);
+        std::cerr<<(idom?idom->GetName():"-")<<", df {";
+        for(auto df:GetFrontier(bb))
+            std::cerr<<" "<<df->GetName();
+        std::cerr<<" }\n";
+    }
+}
@@ -0,0 +1,114 @@
+#include "../../include/ir/opt/gvn.hpp"
+#include "../../include/ir/opt/licm.hpp"
+
+bool GVN::run(Function* f){
+    func=f;
+    dom=AM.get<DominatorTree>(func);
+    return RunOnBlock(func->front());
+}
+
+bool GVN::CanNumber(User* inst){
+    if(dynamic_cast<BinaryInst*>(inst))
+        return inst->GetInstId()!=User::OpID::BinaryUnknown;
+    return dynamic_cast<GetElementPtrInst*>(inst)||dynamic_cast<ZextInst*>(inst)
+         ||dynamic_cast<FPTSI*>(inst)||dynamic_cast<SITFP*>(inst);
+}
+
+/// @brief 沿 GEP 链把常数下标折成相对基地址的字节偏移, 有非常数下标时返回 false
+static bool GetConstOffset(Value* ptr,Value*& base,int& offset){
+    offset=0;
+    while(auto gep=dynamic_cast<GetElementPtrInst*>(ptr)){
+        auto tp=gep->GetOperand(0)->GetType();
+        for(int i=1;i<gep->Getuselist().size();i++){
+            tp=dynamic_cast<HasSubType*>(tp)->GetSubType();
+            auto cint=dynamic_cast<ConstIRInt*>(gep->GetOperand(i));
+            if(cint==nullptr)
+                return false;
+            offset+=cint->GetVal()*tp->get_size();
+        }
+        ptr=gep->GetOperand(0);
+    }
+    base=ptr;
+    return true;
+}
+
+/// @note alloca 和全局变量是互不相交的内存, 基地址不同就不会别名; 参数传进来的指针可能指向任意全局数组
+bool GVN::MayAlias(Value* lhs,Value* rhs){
+    if(lhs==rhs)
+        return true;
+    auto lbase=LICM::GetBaseAddr(lhs),rbase=LICM::GetBaseAddr(rhs);
+    if(lbase!=rbase){
+        if(dynamic_cast<AllocaInst*>(lbase)||dynamic_cast<AllocaInst*>(rbase))
+            return false;
+        return !(lbase->isGlobal()&&rbase->isGlobal());
+    }
+    // SysY 里能 load/store 的元素都是 4 字节, 常数偏移不同就一定不重叠
+    int loff,roff;
+    if(GetConstOffset(lhs,lbase,loff)&&GetConstOffset(rhs,rbase,roff))
+        return loff==roff;
+    return true;
+}
+
+void GVN::KillAlias(Value* ptr){
+    for(auto iter=avail.begin();iter!=avail.end();){
+        if(MayAlias(iter->first,ptr))
+            iter=avail.erase(iter);
+        else
+            ++iter;
+    }
+}
+
+bool GVN::EliminateLoad(LoadInst* load){
+    auto ptr=load->GetOperand(0);
+    auto iter=avail.find(ptr);
+    if(iter==avail.end()||iter->second->GetType()!=load->GetType()){
+        avail[ptr]=load;
+        return false;
+    }
+    load->RAUW(iter->second);
+    delete load;
+    return true;
+}
+
+/// @note 操作数总在当前指令之前被编号过, 表里的指令插入后操作数不会再变, 哈希值是稳定的
+bool GVN::RunOnBlock(BasicBlock* bb){
+    ValueTable::Scope scope(table);
+    avail.clear();
+    bool modified=false;
+    for(auto iter=bb->begin();iter!=bb->end();){
+        auto inst=*iter;
+        ++iter;
+        if(auto load=dynamic_cast<LoadInst*>(inst)){
+            modified|=EliminateLoad(load);
+            continue;
+        }
+        if(auto store=dynamic_cast<StoreInst*>(inst)){
+            auto ptr=store->GetOperand(1);
+            KillAlias(ptr);
+            avail[ptr]=store->GetOperand(0);
+            continue;
+        }
+        if(auto call=dynamic_cast<CallInst*>(inst)){
+            if(dynamic_cast<Function*>(call->GetOperand(0)))
+                avail.clear();
+            else{
+                auto name=call->GetOperand(0)->GetName();
+                if(name=="getarray"||name=="getfarray"||name=="llvm.memcpy.p0.p0.i32"||name=="memcpy@plt"||name=="llvm.memset.p0.i32"||name=="memset@plt")
+                    KillAlias(call->GetOperand(1));
+            }
+            continue;
+        }
+        if(!CanNumber(inst))
+            continue;
+        if(auto same=table.lookup(inst)){
+            inst->RAUW(same);
+            delete inst;
+            modified=true;
+        }
+        else
+            table.Insert(inst,inst);
+    }
+    for(auto child:dom->GetChildren(bb))
+        modified|=RunOnBlock(child);
+    return modified;
+}
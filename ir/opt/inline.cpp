@@ -0,0 +1,149 @@
+#include "../../include/ir/opt/inline.hpp"
+#include <algorithm>
+
+std::pair<size_t,size_t>& InlineCost::Refresh(Function* func){
+    func->inlineinfo={0,0};
+    return func->GetInlineInfo();
+}
+
+InlineCost::InlineLevel InlineCost::GetLevel(Function* callee){
+    if(callee->GetName()=="main"||recursive.find(callee)!=recursive.end())
+        return Function::NeverInline;
+    auto [size,frame]=Refresh(callee);
+    if(frame>MaxFrameSize)
+        return Function::NeverInline;
+    // 只有一个调用点的函数内联后代码不会变多
+    if(size<=TinySize||callsites[callee]==1)
+        return Function::AlwaysInline;
+    return Function::VaiableInline;
+}
+
+bool InlineCost::ShouldInline(Function* caller,Function* callee,int depth){
+    auto level=GetLevel(callee);
+    if(level==Function::NeverInline)
+        return false;
+    auto size=callee->GetInlineInfo().first;
+    if(Refresh(caller).first+size>MaxCallerSize)
+        return false;
+    if(level==Function::AlwaysInline)
+        return true;
+    return size<=Threshold+LoopBonus*std::min(depth,MaxBonusDepth);
+}
+
+bool Inliner::run(Module* m){
+    module=m;
+    BuildCallGraph();
+    InlineCost cost(recursive,callsites);
+    bool modified=false;
+    for(auto func:order)
+        modified|=RunOnFunction(func,cost);
+    return modified;
+}
+
+void Inliner::BuildCallGraph(){
+    callees.clear();
+    callsites.clear();
+    recursive.clear();
+    order.clear();
+    for(auto& func:module->GetFuncTion())
+        for(auto bb:*func)
+            for(auto inst:*bb)
+                if(auto call=dynamic_cast<CallInst*>(inst))
+                    if(auto callee=dynamic_cast<Function*>(call->GetOperand(0))){
+                        callees[func.get()].insert(callee);
+                        callsites[callee]++;
+                    }
+    std::set<Function*> visited;
+    std::vector<Function*> path;
+    for(auto& func:module->GetFuncTion())
+        if(visited.find(func.get())==visited.end())
+            DFS(func.get(),visited,path);
+}
+
+/// @brief 后序就是被调函数在前的顺序; 搜到栈上的函数说明成环, 环上的函数都是递归的
+void Inliner::DFS(Function* func,std::set<Function*>& visited,std::vector<Function*>& path){
+    visited.insert(func);
+    path.push_back(func);
+    for(auto callee:callees[func]){
+        auto iter=std::find(path.begin(),path.end(),callee);
+        if(iter!=path.end())
+            recursive.insert(iter,path.end());
+        else if(visited.find(callee)==visited.end())
+            DFS(callee,visited,path);
+    }
+    path.pop_back();
+    order.push_back(func);
+}
+
+/// @note 调用点的循环深度要在改 CFG 之前拿
+bool Inliner::RunOnFunction(Function* func,InlineCost& cost){
+    auto loopinfo=AM.get<LoopInfo>(func);
+    std::vector<std::pair<CallInst*,int>> calls;
+    for(auto bb:*func)
+        for(auto inst:*bb)
+            if(auto call=dynamic_cast<CallInst*>(inst))
+                if(dynamic_cast<Function*>(call->GetOperand(0)))
+                    calls.emplace_back(call,loopinfo->GetLoopDepth(bb));
+    bool modified=false;
+    for(auto [call,depth]:calls){
+        auto callee=dynamic_cast<Function*>(call->GetOperand(0));
+        if(!cost.ShouldInline(func,callee,depth))
+            continue;
+        InlineCall(call);
+        module->hasInlinedFunc.insert(func);
+        module->inlinedFunc.insert(callee);
+        modified=true;
+    }
+    return modified;
+}
+
+/// @brief 在 call 处把块一分为二, 中间接上 clone 出来的被调函数体, ret 改成跳到后半块
+void Inliner::InlineCall(CallInst* call){
+    auto bb=call->GetParent();
+    auto caller=bb->GetParent();
+    auto callee=dynamic_cast<Function*>(call->GetOperand(0));
+    auto after=bb->SplitAt(call);
+    mylist<Function,BasicBlock>::iterator(bb).insert_after(after);
+
+    std::unordered_map<Operand,Operand> mapping;
+    auto& params=callee->GetParams();
+    for(int i=0;i<params.size();i++)
+        mapping[params[i].get()]=call->GetOperand(i+1);
+    std::vector<BasicBlock*> blocks;
+    for(auto block:*callee){
+        auto clone=block->clone(mapping);
+        mylist<Function,BasicBlock>::iterator(after).insert_before(clone);
+        blocks.push_back(clone);
+    }
+    bb->push_back(new UnCondInst(blocks.front()));
+
+    std::vector<std::pair<Value*,BasicBlock*>> rets;
+    std::vector<AllocaInst*> allocas;
+    for(auto block:blocks){
+        for(auto inst:*block)
+            if(auto alloca=dynamic_cast<AllocaInst*>(inst))
+                allocas.push_back(alloca);
+        if(auto ret=dynamic_cast<RetInst*>(block->back())){
+            if(!ret->Getuselist().empty())
+                rets.emplace_back(ret->GetOperand(0),block);
+            delete ret;
+            block->push_back(new UnCondInst(after));
+        }
+    }
+    // alloca 放回入口块, 内联进循环时也只占一份栈帧
+    for(auto alloca:allocas){
+        alloca->EraseFromParent();
+        caller->front()->push_front(alloca);
+    }
+
+    if(rets.size()==1)
+        call->RAUW(rets[0].first);
+    else if(rets.size()>1){
+        auto phi=PhiInst::NewPhiNode(call,after,call->GetType());
+        for(auto [val,block]:rets)
+            phi->updateIncoming(val,block);
+        call->RAUW(phi);
+    }
+    delete call;
+    caller->CFGChanged();
+}
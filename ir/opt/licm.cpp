@@ -0,0 +1,151 @@
+#include "../../include/ir/opt/licm.hpp"
+#include <algorithm>
+
+bool LICM::run(Function* f){
+    func=f;
+    bool modified=InsertPreheaders();
+    dom=AM.get<DominatorTree>(func);
+    loopinfo=AM.get<LoopInfo>(func);
+    auto loops=loopinfo->GetLoops();
+    for(auto iter=loops.rbegin();iter!=loops.rend();++iter)
+        modified|=RunOnLoop(*iter);
+    return modified;
+}
+
+/// @brief 补 preheader 会改 CFG, 每补一个都重新拿一次循环信息
+bool LICM::InsertPreheaders(){
+    bool modified=false;
+    bool changed=true;
+    while(changed){
+        changed=false;
+        loopinfo=AM.get<LoopInfo>(func);
+        for(auto loop:loopinfo->GetLoops())
+            if(loopinfo->InsertPreheader(loop)!=nullptr){
+                modified=changed=true;
+                break;
+            }
+    }
+    return modified;
+}
+
+Value* LICM::GetBaseAddr(Value* ptr){
+    while(auto gep=dynamic_cast<GetElementPtrInst*>(ptr))
+        ptr=gep->GetOperand(0);
+    return ptr;
+}
+
+void LICM::ClobberPointer(Value* ptr){
+    auto base=GetBaseAddr(ptr);
+    if(base->isGlobal())
+        clobbered.insert(base);
+    else if(dynamic_cast<AllocaInst*>(base)==nullptr)
+        clobber_arrays=true;
+}
+
+/// @note 标量全局变量在 SysY 里取不了地址, 只有直接 store 它才会被改
+void LICM::CalcClobber(Loop* loop){
+    clobbered.clear();
+    clobber_arrays=false;
+    clobber_all=false;
+    for(auto bb:loop->GetBlocks())
+        for(auto inst:*bb){
+            if(auto store=dynamic_cast<StoreInst*>(inst))
+                ClobberPointer(store->GetOperand(1));
+            else if(auto call=dynamic_cast<CallInst*>(inst)){
+                if(dynamic_cast<Function*>(call->GetOperand(0))){
+                    clobber_all=true;
+                    return;
+                }
+                auto name=call->GetOperand(0)->GetName();
+                if(name=="getarray"||name=="getfarray")
+                    ClobberPointer(call->GetOperand(1));
+                else if(name=="llvm.memcpy.p0.p0.i32"||name=="memcpy@plt"||name=="llvm.memset.p0.i32"||name=="memset@plt")
+                    ClobberPointer(call->GetOperand(1));
+            }
+        }
+}
+
+bool LICM::IsInvariant(Loop* loop,Value* val){
+    if(auto inst=dynamic_cast<User*>(val))
+        if(inst->GetParent()!=nullptr&&loop->Contains(inst->GetParent()))
+            return false;
+    return true;
+}
+
+bool LICM::AlwaysExecuted(Loop* loop,BasicBlock* bb){
+    for(auto exiting:loop->GetExiting())
+        if(!dom->dominates(bb,exiting))
+            return false;
+    return true;
+}
+
+bool LICM::CanHoistLoad(Loop* loop,LoadInst* load){
+    auto ptr=load->GetOperand(0);
+    auto base=GetBaseAddr(ptr);
+    if(!base->isGlobal()||clobber_all)
+        return false;
+    if(clobbered.find(base)!=clobbered.end())
+        return false;
+    if(ptr!=base&&clobber_arrays)
+        return false;
+    // 下标都是常数的访问一定不越界, 其余的要保证原来每次进循环都会执行
+    auto gep=dynamic_cast<GetElementPtrInst*>(ptr);
+    while(gep!=nullptr){
+        for(int i=1;i<gep->Getuselist().size();i++)
+            if(!gep->GetOperand(i)->isConst())
+                return AlwaysExecuted(loop,load->GetParent());
+        gep=dynamic_cast<GetElementPtrInst*>(gep->GetOperand(0));
+    }
+    return true;
+}
+
+bool LICM::CanHoist(Loop* loop,User* inst){
+    if(auto load=dynamic_cast<LoadInst*>(inst)){
+        if(!IsInvariant(loop,load->GetOperand(0)))
+            return false;
+        return CanHoistLoad(loop,load);
+    }
+    if(dynamic_cast<GetElementPtrInst*>(inst)==nullptr&&dynamic_cast<BinaryInst*>(inst)==nullptr)
+        return false;
+    for(auto& use:inst->Getuselist())
+        if(!IsInvariant(loop,use->GetValue()))
+            return false;
+    if(auto bin=dynamic_cast<BinaryInst*>(inst)){
+        if(bin->IsCmpInst())
+            return false;
+        // 除零在 IR 层面是未定义行为, 除数不是非零常数时不能投机执行
+        auto op=bin->getopration();
+        if(op==BinaryInst::Op_Div||op==BinaryInst::Op_Mod){
+            auto divisor=bin->GetOperand(1);
+            bool nonzero=false;
+            if(auto cint=dynamic_cast<ConstIRInt*>(divisor))
+                nonzero=cint->GetVal()!=0;
+            else if(auto cfloat=dynamic_cast<ConstIRFloat*>(divisor))
+                nonzero=cfloat->GetVal()!=0;
+            if(!nonzero&&!AlwaysExecuted(loop,inst->GetParent()))
+                return false;
+        }
+    }
+    return true;
+}
+
+/// @brief 按 DFS 前序扫循环体, 定值块总在使用块之前, 一趟就能把不变量链整条提出去
+bool LICM::RunOnLoop(Loop* loop){
+    auto preheader=loop->GetPreheader();
+    if(preheader==nullptr)
+        return false;
+    CalcClobber(loop);
+    auto term=preheader->back();
+    bool modified=false;
+    for(auto bb:loop->GetBlocks())
+        for(auto iter=bb->begin();iter!=bb->end();){
+            auto inst=*iter;
+            ++iter;
+            if(!CanHoist(loop,inst))continue;
+            // 立刻挪走, 后面依赖它的指令才能看出是不变量
+            inst->EraseFromParent();
+            mylist<BasicBlock,User>::iterator(term).insert_before(inst);
+            modified=true;
+        }
+    return modified;
+}
@@ -0,0 +1,167 @@
+#include "../../include/ir/opt/lsr.hpp"
+#include <algorithm>
+
+bool LoopStrengthReduce::run(Function* f){
+    func=f;
+    indvar=AM.get<InductionVar>(func);
+    auto loops=AM.get<LoopInfo>(func)->GetLoops();
+    bool modified=false;
+    // 先做内层, 内层指针的初值落在外层循环里, 还能被外层继续削弱
+    for(auto iter=loops.rbegin();iter!=loops.rend();++iter)
+        modified|=RunOnLoop(*iter);
+    return modified;
+}
+
+bool LoopStrengthReduce::IsInvariant(Loop* loop,Value* val){
+    if(auto inst=dynamic_cast<User*>(val))
+        if(inst->GetParent()!=nullptr&&loop->Contains(inst->GetParent()))
+            return false;
+    return true;
+}
+
+bool LoopStrengthReduce::RunOnLoop(Loop* loop){
+    int budget=MaxPtrPhis;
+    bool modified=false;
+    // 改写过程中会删掉归纳变量, 先拷一份
+    auto ivs=indvar->GetIndVars(loop);
+    for(auto& iv:ivs)
+        modified|=RunOnIndVar(&iv,budget);
+    return modified;
+}
+
+/// @brief 收集循环内恰好有一维下标是 val(=iv+offset), 其余操作数都是循环不变量的 GEP
+void LoopStrengthReduce::CollectGEP(BasicIndVar* iv,Value* val,int offset,std::vector<Group>& groups){
+    auto loop=iv->loop;
+    for(auto use:val->GetUserlist()){
+        auto gep=dynamic_cast<GetElementPtrInst*>(use->GetUser());
+        if(gep==nullptr||!loop->Contains(gep->GetParent()))
+            continue;
+        int pos=-1;
+        bool ok=true;
+        std::vector<Value*> key;
+        for(int i=0;i<gep->Getuselist().size()&&ok;i++){
+            auto op=gep->GetOperand(i);
+            if(op==val&&i!=0&&pos==-1){
+                pos=i;
+                key.push_back(nullptr);
+            }
+            else if(op==val||!IsInvariant(loop,op))
+                ok=false;
+            else
+                key.push_back(op);
+        }
+        if(!ok||pos==-1)
+            continue;
+        auto iter=std::find_if(groups.begin(),groups.end(),[&](Group& g){return g.key==key;});
+        if(iter==groups.end()){
+            Group group;
+            group.key=key;
+            group.pos=pos;
+            // 第 pos 维下标加一, 地址走过第 pos 层类型的大小
+            auto tp=gep->GetOperand(0)->GetType();
+            for(int i=1;i<=pos;i++)
+                tp=dynamic_cast<HasSubType*>(tp)->GetSubType();
+            auto elem=dynamic_cast<HasSubType*>(gep->GetType())->GetSubType();
+            group.scale=tp->get_size()/elem->get_size();
+            groups.push_back(group);
+            iter=groups.end()-1;
+        }
+        iter->geps.emplace_back(gep,offset);
+    }
+}
+
+bool LoopStrengthReduce::RunOnIndVar(BasicIndVar* iv,int& budget){
+    std::vector<Group> groups;
+    std::vector<User*> offsets;
+    CollectGEP(iv,iv->phi,0,groups);
+    for(auto use:iv->phi->GetUserlist()){
+        auto user=use->GetUser();
+        int offset=0;
+        if(user!=(User*)iv->phi&&InductionVar::GetOffset(iv,user,offset)){
+            CollectGEP(iv,user,offset,groups);
+            offsets.push_back(user);
+        }
+    }
+    if(groups.empty())
+        return false;
+
+    int rewritten=0;
+    for(auto& group:groups){
+        if(budget==0)break;
+        Rewrite(iv,group);
+        budget--;
+        rewritten++;
+    }
+    // a[i+1] 之类的下标只用来寻址的话已经没用了
+    for(auto user:offsets)
+        if(user!=iv->next&&user->GetUserListSize()==0)
+            delete user;
+    if(rewritten==groups.size())
+        ReplaceExitTest(iv,groups[0]);
+    return true;
+}
+
+/// @brief 建指针 phi: p=phi [&base[..][init][..], preheader], [p+step*scale, latch]
+void LoopStrengthReduce::Rewrite(BasicIndVar* iv,Group& group){
+    auto loop=iv->loop;
+    auto preheader=loop->GetPreheader();
+    auto latch=loop->GetLatches()[0];
+    auto header=loop->GetHeader();
+
+    std::vector<Operand> index(group.key.begin()+1,group.key.end());
+    index[group.pos-1]=iv->init;
+    auto start=new GetElementPtrInst(group.key[0],index);
+    mylist<BasicBlock,User>::iterator(preheader->back()).insert_before(start);
+
+    auto ptr=PhiInst::NewPhiNode(header->front(),header,start->GetType());
+    std::vector<Operand> stride{ConstIRInt::GetNewConstant(iv->step*group.scale)};
+    auto next=new GetElementPtrInst(ptr,stride);
+    mylist<BasicBlock,User>::iterator(iv->next).insert_after(next);
+    ptr->updateIncoming(start,preheader);
+    ptr->updateIncoming(next,latch);
+    group.ptr=ptr;
+
+    for(auto [gep,offset]:group.geps){
+        std::vector<Operand> off{ConstIRInt::GetNewConstant(offset*group.scale)};
+        auto addr=new GetElementPtrInst(ptr,off);
+        mylist<BasicBlock,User>::iterator(gep).insert_before(addr);
+        gep->RAUW(addr);
+        delete gep;
+    }
+}
+
+/// @brief i 只剩下自增和一条与循环不变量的比较时, 把比较换成 p 和 &base[..][bound][..] 比, 然后删掉 i
+/// @note 元素大小为正, i 和 p 单调性相同, 任意比较运算都等价
+bool LoopStrengthReduce::ReplaceExitTest(BasicIndVar* iv,Group& group){
+    auto loop=iv->loop;
+    if(iv->next->GetUserListSize()!=1)
+        return false;
+    BinaryInst* cmp=nullptr;
+    for(auto use:iv->phi->GetUserlist()){
+        auto user=use->GetUser();
+        if(user==iv->next)
+            continue;
+        auto bin=dynamic_cast<BinaryInst*>(user);
+        if(bin==nullptr||!bin->IsCmpInst()||cmp!=nullptr||!loop->Contains(bin->GetParent()))
+            return false;
+        cmp=bin;
+    }
+    if(cmp==nullptr)
+        return false;
+    int ivpos=(cmp->GetOperand(0)==iv->phi)?0:1;
+    auto bound=cmp->GetOperand(1-ivpos);
+    if(bound==iv->phi||!IsInvariant(loop,bound))
+        return false;
+
+    std::vector<Operand> index(group.key.begin()+1,group.key.end());
+    index[group.pos-1]=bound;
+    auto end=new GetElementPtrInst(group.key[0],index);
+    mylist<BasicBlock,User>::iterator(loop->GetPreheader()->back()).insert_before(end);
+    cmp->RSUW(ivpos,group.ptr);
+    cmp->RSUW(1-ivpos,end);
+
+    iv->next->RAUW(UndefValue::get(iv->next->GetType()));
+    delete iv->next;
+    delete iv->phi;
+    return true;
+}
@@ -0,0 +1,216 @@
+#include "../../include/ir/opt/mem2reg.hpp"
+#include "../../util/my_stl.hpp"
+#include <algorithm>
+
+bool Mem2reg::run(Function* f){
+    func=f;
+    allocas.clear();
+    alloca_index.clear();
+    phi2alloca.clear();
+    bool modified=RemoveUnreachable();
+
+    for(auto inst:*(func->front())){
+        if(auto alloca=dynamic_cast<AllocaInst*>(inst))
+            if(Promotable(alloca)){
+                alloca_index[alloca]=allocas.size();
+                allocas.push_back(alloca);
+            }
+    }
+    if(allocas.empty())
+        return modified;
+
+    dom=AM.get<DominatorTree>(func);
+    InsertPhi();
+
+    std::vector<std::vector<Value*>> incoming(allocas.size());
+    Rename(func->front(),incoming);
+
+    for(auto alloca:allocas){
+        assert(alloca->GetUserlist().is_empty()&&"Promoted Alloca Still In Use");
+        delete alloca;
+    }
+    RemoveDeadPhi();
+    return true;
+}
+
+/// @brief 只有 int/float/指针类型, 且所有 use 都是 load 或者作为 store 目的地址的 alloca 才能提升
+bool Mem2reg::Promotable(AllocaInst* alloca){
+    auto tp=dynamic_cast<PointerType*>(alloca->GetType())->GetSubType();
+    auto tpenum=tp->GetTypeEnum();
+    if(tpenum!=IR_Value_INT&&tpenum!=IR_Value_Float&&tpenum!=IR_PTR)
+        return false;
+    for(auto use:alloca->GetUserlist()){
+        auto user=use->GetUser();
+        if(dynamic_cast<LoadInst*>(user))
+            continue;
+        if(auto store=dynamic_cast<StoreInst*>(user))
+            if(store->GetOperand(1)==alloca&&store->GetOperand(0)!=alloca)
+                continue;
+        return false;
+    }
+    return true;
+}
+
+/// @brief 删掉入口不可达的块, 否则它们会作为前驱出现在 phi 里
+bool Mem2reg::RemoveUnreachable(){
+    std::set<BasicBlock*> reach;
+    std::vector<BasicBlock*> worklist{func->front()};
+    reach.insert(func->front());
+    while(!worklist.empty()){
+        auto bb=worklist.back();
+        worklist.pop_back();
+        auto term=bb->back();
+        if(term==nullptr)continue;
+        std::vector<BasicBlock*> nxt;
+        if(term->IsCondInst()){
+            nxt.push_back(term->GetOperand(1)->as<BasicBlock>());
+            nxt.push_back(term->GetOperand(2)->as<BasicBlock>());
+        }
+        else if(term->IsUncondInst())
+            nxt.push_back(term->GetOperand(0)->as<BasicBlock>());
+        for(auto succ:nxt)
+            if(reach.insert(succ).second)
+                worklist.push_back(succ);
+    }
+    std::vector<BasicBlock*> dead;
+    for(auto bb:*func)
+        if(reach.find(bb)==reach.end())
+            dead.push_back(bb);
+    if(dead.empty())
+        return false;
+    // 死块里的值只可能被死块使用, 先断开所有的 use 再统一删除
+    for(auto bb:dead)
+        for(auto inst:*bb)
+            if(!inst->GetUserlist().is_empty())
+                inst->RAUW(UndefValue::get(inst->GetType()));
+    for(auto bb:dead){
+        for(auto iter=bb->begin();iter!=bb->end();){
+            auto inst=*iter;
+            ++iter;
+            delete inst;
+        }
+    }
+    for(auto bb:dead){
+        assert(bb->GetUserlist().is_empty()&&"Dead Block Still Used");
+        delete bb;
+    }
+    func->CFGChanged();
+    return true;
+}
+
+void Mem2reg::InsertPhi(){
+    for(int i=0;i<allocas.size();i++){
+        auto alloca=allocas[i];
+        auto tp=dynamic_cast<PointerType*>(alloca->GetType())->GetSubType();
+        std::set<BasicBlock*> defblocks;
+        for(auto use:alloca->GetUserlist())
+            if(auto store=dynamic_cast<StoreInst*>(use->GetUser()))
+                defblocks.insert(store->GetParent());
+        std::vector<BasicBlock*> worklist(defblocks.begin(),defblocks.end());
+        std::set<BasicBlock*> hasphi;
+        while(!worklist.empty()){
+            auto bb=worklist.back();
+            worklist.pop_back();
+            for(auto df:dom->GetFrontier(bb)){
+                if(!hasphi.insert(df).second)continue;
+                auto phi=PhiInst::NewPhiNode(df->front(),df,tp);
+                phi2alloca[phi]=i;
+                if(defblocks.insert(df).second)
+                    worklist.push_back(df);
+            }
+        }
+    }
+}
+
+/// @brief incoming[i] 是沿支配树走到当前块时 allocas[i] 的值栈
+void Mem2reg::Rename(BasicBlock* bb,std::vector<std::vector<Value*>>& incoming){
+    std::vector<int> pushed;
+    for(auto iter=bb->begin();iter!=bb->end();){
+        auto inst=*iter;
+        ++iter;
+        if(auto phi=dynamic_cast<PhiInst*>(inst)){
+            auto it=phi2alloca.find(phi);
+            if(it!=phi2alloca.end()){
+                incoming[it->second].push_back(phi);
+                pushed.push_back(it->second);
+            }
+        }
+        else if(auto load=dynamic_cast<LoadInst*>(inst)){
+            auto alloca=dynamic_cast<AllocaInst*>(load->GetOperand(0));
+            if(alloca==nullptr||alloca_index.find(alloca)==alloca_index.end())
+                continue;
+            auto& stack=incoming[alloca_index[alloca]];
+            Value* val=nullptr;
+            if(!stack.empty())
+                val=stack.back();
+            else{
+                // 未初始化就读, 给 0 就好
+                val=ConstantData::getNullValue(load->GetType());
+                if(val==nullptr)
+                    val=UndefValue::get(load->GetType());
+            }
+            load->RAUW(val);
+            delete load;
+        }
+        else if(auto store=dynamic_cast<StoreInst*>(inst)){
+            auto alloca=dynamic_cast<AllocaInst*>(store->GetOperand(1));
+            if(alloca==nullptr||alloca_index.find(alloca)==alloca_index.end())
+                continue;
+            int idx=alloca_index[alloca];
+            incoming[idx].push_back(store->GetOperand(0));
+            pushed.push_back(idx);
+            delete store;
+        }
+    }
+    for(auto succ:dom->GetSuccs(bb)){
+        for(auto inst:*succ){
+            auto phi=dynamic_cast<PhiInst*>(inst);
+            if(phi==nullptr)break;
+            auto it=phi2alloca.find(phi);
+            if(it==phi2alloca.end())continue;
+            auto& stack=incoming[it->second];
+            Value* val=stack.empty()?UndefValue::get(phi->GetType()):stack.back();
+            phi->updateIncoming(val,bb);
+        }
+    }
+    for(auto child:dom->GetChildren(bb))
+        Rename(child,incoming);
+    for(auto idx:pushed)
+        incoming[idx].pop_back();
+}
+
+/// @brief 只删掉本 pass 插入且最终没人用的 phi, phi 之间互相使用的环也一起删
+void Mem2reg::RemoveDeadPhi(){
+    std::set<PhiInst*> live;
+    std::vector<PhiInst*> worklist;
+    for(auto& [phi,idx]:phi2alloca){
+        for(auto use:phi->GetUserlist()){
+            auto user=dynamic_cast<PhiInst*>(use->GetUser());
+            if(user==nullptr||phi2alloca.find(user)==phi2alloca.end()){
+                live.insert(phi);
+                worklist.push_back(phi);
+                break;
+            }
+        }
+    }
+    while(!worklist.empty()){
+        auto phi=worklist.back();
+        worklist.pop_back();
+        for(auto& use:phi->Getuselist())
+            if(auto src=dynamic_cast<PhiInst*>(use->GetValue()))
+                if(phi2alloca.find(src)!=phi2alloca.end()&&live.insert(src).second)
+                    worklist.push_back(src);
+    }
+    std::vector<PhiInst*> dead;
+    for(auto& [phi,idx]:phi2alloca)
+        if(live.find(phi)==live.end())
+            dead.push_back(phi);
+    // 先断开死 phi 之间的引用, 避免析构时连带删除
+    for(auto phi:dead)
+        if(!phi->GetUserlist().is_empty())
+            phi->RAUW(UndefValue::get(phi->GetType()));
+    for(auto phi:dead){
+        phi2alloca.erase(phi);
+        delete phi;
+    }
+}
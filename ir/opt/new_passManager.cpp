@@ -1,2 +1,90 @@
 #include "../../include/ir/opt/New_passManager.hpp"
-#include "../../include/lib/CFG.hpp"
\ No newline at end of file
+#include "../../include/lib/CFG.hpp"
+#include "../../include/ir/opt/mem2reg.hpp"
+#include "../../include/ir/opt/gvn.hpp"
+#include "../../include/ir/opt/inline.hpp"
+#include "../../include/ir/opt/sccp.hpp"
+#include "../../include/ir/opt/adce.hpp"
+#include "../../include/ir/opt/LoopInfo.hpp"
+#include "../../include/ir/opt/licm.hpp"
+#include "../../include/ir/opt/lsr.hpp"
+#include "../../include/ir/opt/unroll.hpp"
+#include "../../include/ir/opt/simplifycfg.hpp"
+#include "../../include/ir/opt/tailrec.hpp"
+
+bool FunctionPassAdaptor::run(Module* m){
+    bool modified=false;
+    for(auto& func:m->GetFuncTion()){
+        if(pass->run(func.get())){
+            AM.invalidate(func.get());
+            modified=true;
+        }
+    }
+    return modified;
+}
+
+PassManager::PassManager(OptLevel _level):level(_level){
+    InitPipeline();
+}
+
+void PassManager::InitPipeline(){
+    switch(level){
+        case O2:
+        case O1:
+            AddPass("mem2reg",new Mem2reg(AM));
+            // 尾递归变成循环之后就不再是递归函数, 可以内联
+            AddPass("tailrec",new TailRecElim(AM));
+            AddPass("inline",new Inliner(AM));
+            AddPass("sccp",new SCCP(AM));
+            AddPass("adce",new ADCE(AM));
+            // licm 会把需要的 preheader 补回来
+            AddPass("simplifycfg",new SimplifyCFG(AM));
+            AddPass("gvn",new GVN(AM));
+            AddPass("licm",new LICM(AM));
+            AddPass("lsr",new LoopStrengthReduce(AM));
+            AddPass("unroll",new LoopUnroll(AM));
+            // 完全展开后留下的空循环靠 sccp 删, 复制出来的地址计算交给 gvn 合并
+            AddPass("sccp",new SCCP(AM));
+            AddPass("gvn",new GVN(AM));
+            AddPass("adce",new ADCE(AM));
+            AddPass("simplifycfg",new SimplifyCFG(AM));
+            break;
+        case O0:
+        default:
+            break;
+    }
+}
+
+void PassManager::AddPass(std::string name,ModulePass* pass){
+    pipeline.emplace_back(name,std::unique_ptr<ModulePass>(pass));
+}
+
+void PassManager::AddPass(std::string name,FunctionPass* pass){
+    pipeline.emplace_back(name,std::make_unique<FunctionPassAdaptor>(pass,AM));
+}
+
+bool PassManager::run(Module* m){
+    bool modified=false;
+    for(auto& [name,pass]:pipeline){
+        if(pass->run(m)){
+            // module pass 可能改动任意函数
+            AM.invalidate();
+            modified=true;
+        }
+    }
+    // 后端的溢出代价要用 LoopDepth, 不管优化等级都标一遍
+    for(auto& func:m->GetFuncTion())
+        AM.get<LoopInfo>(func.get());
+    return modified;
+}
+
+PassManager::OptLevel PassManager::ParseOptLevel(const char* arg){
+    if(arg==nullptr)
+        return O1;
+    std::string str(arg);
+    if(str=="0")return O0;
+    if(str=="1")return O1;
+    if(str=="2"||str=="3")return O2;
+    std::cerr<<"Unknown Opt Level -O"<<str<<", Fall Back To -O0\n";
+    return O0;
+}
@@ -0,0 +1,284 @@
+#include "../../include/ir/opt/sccp.hpp"
+#include <climits>
+
+bool SCCP::run(Function* f){
+    func=f;
+    value.clear();
+    executable.clear();
+    edges.clear();
+    blockworklist.clear();
+    instworklist.clear();
+
+    executable.insert(func->front());
+    blockworklist.push_back(func->front());
+    do
+        Solve();
+    while(ResolveUndefBranch());
+
+    bool modified=Rewrite();
+    modified|=RemoveDeadBlocks();
+    return modified;
+}
+
+void SCCP::Solve(){
+    while(!blockworklist.empty()||!instworklist.empty()){
+        while(!instworklist.empty()){
+            auto inst=instworklist.back();
+            instworklist.pop_back();
+            if(executable.find(inst->GetParent())!=executable.end())
+                Visit(inst);
+        }
+        while(!blockworklist.empty()){
+            auto bb=blockworklist.back();
+            blockworklist.pop_back();
+            for(auto inst:*bb)
+                Visit(inst);
+        }
+    }
+}
+
+bool SCCP::ResolveUndefBranch(){
+    bool changed=false;
+    for(auto bb:executable){
+        auto cond=dynamic_cast<CondInst*>(bb->back());
+        if(cond==nullptr||GetLattice(cond->GetOperand(0)).state!=Lattice::Undef)
+            continue;
+        for(int i=1;i<=2;i++){
+            auto succ=cond->GetOperand(i)->as<BasicBlock>();
+            if(edges.find(std::make_pair(bb,succ))==edges.end()){
+                MarkEdge(bb,succ);
+                changed=true;
+            }
+        }
+    }
+    return changed;
+}
+
+SCCP::Lattice SCCP::GetLattice(Value* val){
+    Lattice lat;
+    if(dynamic_cast<ConstIRInt*>(val)||dynamic_cast<ConstIRFloat*>(val)||dynamic_cast<ConstIRBoolean*>(val)){
+        lat.state=Lattice::Const;
+        lat.val=val;
+        return lat;
+    }
+    if(dynamic_cast<UndefValue*>(val))
+        return lat;
+    // 形参/全局变量等不是本函数指令的值都当作未知
+    auto inst=dynamic_cast<User*>(val);
+    if(inst==nullptr||inst->GetParent()==nullptr){
+        lat.state=Lattice::Overdefined;
+        return lat;
+    }
+    return value[val];
+}
+
+void SCCP::MarkOverdefined(User* inst){
+    auto& lat=value[inst];
+    if(lat.state==Lattice::Overdefined)
+        return;
+    lat.state=Lattice::Overdefined;
+    lat.val=nullptr;
+    for(auto use:inst->GetUserlist())
+        instworklist.push_back(use->GetUser());
+}
+
+void SCCP::MarkConst(User* inst,Value* val){
+    auto& lat=value[inst];
+    if(lat.state==Lattice::Const&&lat.val==val)
+        return;
+    if(lat.state!=Lattice::Undef){
+        MarkOverdefined(inst);
+        return;
+    }
+    lat.state=Lattice::Const;
+    lat.val=val;
+    for(auto use:inst->GetUserlist())
+        instworklist.push_back(use->GetUser());
+}
+
+/// @brief 新的边第一次到达某个块时整块入队, 否则只需要重新算块里的 phi
+void SCCP::MarkEdge(BasicBlock* from,BasicBlock* to){
+    if(!edges.insert(std::make_pair(from,to)).second)
+        return;
+    if(executable.insert(to).second){
+        blockworklist.push_back(to);
+        return;
+    }
+    for(auto inst:*to){
+        if(dynamic_cast<PhiInst*>(inst)==nullptr)break;
+        instworklist.push_back(inst);
+    }
+}
+
+void SCCP::Visit(User* inst){
+    if(auto phi=dynamic_cast<PhiInst*>(inst)){
+        VisitPhi(phi);
+        return;
+    }
+    if(inst->IsTerminateInst()){
+        VisitBranch(inst);
+        return;
+    }
+    bool foldable=dynamic_cast<BinaryInst*>(inst)||dynamic_cast<ZextInst*>(inst)
+                ||dynamic_cast<FPTSI*>(inst)||dynamic_cast<SITFP*>(inst);
+    if(!foldable){
+        if(inst->GetType()->GetTypeEnum()!=IR_Value_VOID)
+            MarkOverdefined(inst);
+        return;
+    }
+    for(auto& use:inst->Getuselist()){
+        auto lat=GetLattice(use->GetValue());
+        if(lat.state==Lattice::Overdefined){
+            MarkOverdefined(inst);
+            return;
+        }
+        if(lat.state==Lattice::Undef)
+            return;
+    }
+    if(auto val=Fold(inst))
+        MarkConst(inst,val);
+    else
+        MarkOverdefined(inst);
+}
+
+/// @brief 只合并从可执行边流进来的值
+void SCCP::VisitPhi(PhiInst* phi){
+    auto bb=phi->GetParent();
+    Value* result=nullptr;
+    for(auto& [_1,rec]:phi->PhiRecord){
+        if(edges.find(std::make_pair(rec.second,bb))==edges.end())
+            continue;
+        auto lat=GetLattice(rec.first);
+        if(lat.state==Lattice::Undef)
+            continue;
+        if(lat.state==Lattice::Overdefined||(result!=nullptr&&result!=lat.val)){
+            MarkOverdefined(phi);
+            return;
+        }
+        result=lat.val;
+    }
+    if(result!=nullptr)
+        MarkConst(phi,result);
+}
+
+void SCCP::VisitBranch(User* inst){
+    auto bb=inst->GetParent();
+    if(auto uncond=dynamic_cast<UnCondInst*>(inst)){
+        MarkEdge(bb,uncond->GetOperand(0)->as<BasicBlock>());
+        return;
+    }
+    auto cond=dynamic_cast<CondInst*>(inst);
+    if(cond==nullptr)
+        return;
+    auto lat=GetLattice(cond->GetOperand(0));
+    if(lat.state==Lattice::Undef)
+        return;
+    if(lat.state==Lattice::Const){
+        int taken=lat.val->isConstZero()?2:1;
+        MarkEdge(bb,cond->GetOperand(taken)->as<BasicBlock>());
+        return;
+    }
+    MarkEdge(bb,cond->GetOperand(1)->as<BasicBlock>());
+    MarkEdge(bb,cond->GetOperand(2)->as<BasicBlock>());
+}
+
+Value* SCCP::Fold(User* inst){
+    auto GetInt=[](Value* val){
+        if(auto cbool=dynamic_cast<ConstIRBoolean*>(val))
+            return (int)cbool->GetVal();
+        return dynamic_cast<ConstIRInt*>(val)->GetVal();
+    };
+    auto lhs=GetLattice(inst->GetOperand(0)).val;
+    if(dynamic_cast<ZextInst*>(inst))
+        return ConstIRInt::GetNewConstant(GetInt(lhs));
+    if(dynamic_cast<FPTSI*>(inst))
+        return ConstIRInt::GetNewConstant((int)dynamic_cast<ConstIRFloat*>(lhs)->GetVal());
+    if(dynamic_cast<SITFP*>(inst))
+        return ConstIRFloat::GetNewConstant((float)GetInt(lhs));
+
+    auto bin=dynamic_cast<BinaryInst*>(inst);
+    auto rhs=GetLattice(inst->GetOperand(1)).val;
+    auto op=bin->getopration();
+    // 除零和 INT_MIN/-1 留到运行时
+    if(op==BinaryInst::Op_Div||op==BinaryInst::Op_Mod){
+        if(rhs->isConstZero())
+            return nullptr;
+        if(dynamic_cast<ConstIRFloat*>(lhs)==nullptr&&GetInt(lhs)==INT_MIN&&GetInt(rhs)==-1)
+            return nullptr;
+    }
+    auto val=BasicBlock::GenerateBinaryInst(nullptr,lhs,op,rhs);
+    if(inst->GetType()==BoolType::NewBoolTypeGet()&&dynamic_cast<ConstIRInt*>(val))
+        return ConstIRBoolean::GetNewConstant(!val->isConstZero());
+    return val;
+}
+
+bool SCCP::Rewrite(){
+    bool modified=false;
+    for(auto bb:*func){
+        if(executable.find(bb)==executable.end())
+            continue;
+        for(auto iter=bb->begin();iter!=bb->end();){
+            auto inst=*iter;
+            ++iter;
+            if(inst->IsTerminateInst())
+                break;
+            auto iter_val=value.find(inst);
+            if(iter_val==value.end()||iter_val->second.state!=Lattice::Const)
+                continue;
+            inst->RAUW(iter_val->second.val);
+            delete inst;
+            modified=true;
+        }
+        auto cond=dynamic_cast<CondInst*>(bb->back());
+        if(cond==nullptr)
+            continue;
+        auto lat=GetLattice(cond->GetOperand(0));
+        if(lat.state!=Lattice::Const)
+            continue;
+        int taken=lat.val->isConstZero()?2:1;
+        auto target=cond->GetOperand(taken)->as<BasicBlock>();
+        auto other=cond->GetOperand(3-taken)->as<BasicBlock>();
+        if(other!=target)
+            other->RemovePredBB(bb);
+        delete cond;
+        bb->push_back(new UnCondInst(target));
+        func->CFGChanged();
+        modified=true;
+    }
+    return modified;
+}
+
+/// @brief 删除的方式同 Mem2reg::RemoveUnreachable, 只是先把死块从活块的 phi 里摘掉
+bool SCCP::RemoveDeadBlocks(){
+    std::vector<BasicBlock*> dead;
+    for(auto bb:*func)
+        if(executable.find(bb)==executable.end())
+            dead.push_back(bb);
+    if(dead.empty())
+        return false;
+    for(auto bb:dead){
+        auto term=bb->back();
+        if(term==nullptr)continue;
+        for(auto& use:term->Getuselist())
+            if(auto succ=dynamic_cast<BasicBlock*>(use->GetValue()))
+                if(executable.find(succ)!=executable.end())
+                    succ->RemovePredBB(bb);
+    }
+    for(auto bb:dead)
+        for(auto inst:*bb)
+            if(!inst->GetUserlist().is_empty())
+                inst->RAUW(UndefValue::get(inst->GetType()));
+    for(auto bb:dead){
+        for(auto iter=bb->begin();iter!=bb->end();){
+            auto inst=*iter;
+            ++iter;
+            delete inst;
+        }
+    }
+    for(auto bb:dead){
+        assert(bb->GetUserlist().is_empty()&&"Dead Block Still Used");
+        delete bb;
+    }
+    func->CFGChanged();
+    return true;
+}
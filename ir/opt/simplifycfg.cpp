@@ -0,0 +1,210 @@
+#include "../../include/ir/opt/simplifycfg.hpp"
+#include <algorithm>
+#include <set>
+
+bool SimplifyCFG::run(Function* f){
+    func=f;
+    bool modified=false,changed;
+    do{
+        changed=RemoveUnreachable(func);
+        changed|=FoldBranches();
+        changed|=RemoveForwardingBlocks();
+        changed|=MergeBlocks();
+        modified|=changed;
+    }while(changed);
+    if(modified)
+        func->CFGChanged();
+    return modified;
+}
+
+std::vector<BasicBlock*> SimplifyCFG::GetSuccs(BasicBlock* bb){
+    std::vector<BasicBlock*> succs;
+    if(auto term=bb->back())
+        for(auto& use:term->Getuselist())
+            if(auto succ=dynamic_cast<BasicBlock*>(use->GetValue()))
+                succs.push_back(succ);
+    return succs;
+}
+
+bool SimplifyCFG::RemoveUnreachable(Function* func){
+    func->init_reach_block();
+    std::vector<BasicBlock*> worklist{func->front()};
+    func->front()->reachable=true;
+    while(!worklist.empty()){
+        auto bb=worklist.back();
+        worklist.pop_back();
+        for(auto succ:GetSuccs(bb))
+            if(!succ->reachable){
+                succ->reachable=true;
+                worklist.push_back(succ);
+            }
+    }
+    std::vector<BasicBlock*> dead;
+    for(auto bb:*func)
+        if(!bb->reachable)
+            dead.push_back(bb);
+    if(dead.empty())
+        return false;
+    for(auto bb:dead)
+        for(auto succ:GetSuccs(bb))
+            if(succ->reachable)
+                succ->RemovePredBB(bb);
+    for(auto bb:dead)
+        for(auto inst:*bb)
+            if(!inst->GetUserlist().is_empty())
+                inst->RAUW(UndefValue::get(inst->GetType()));
+    for(auto bb:dead){
+        for(auto iter=bb->begin();iter!=bb->end();){
+            auto inst=*iter;
+            ++iter;
+            delete inst;
+        }
+        delete bb;
+    }
+    func->CFGChanged();
+    return true;
+}
+
+void SimplifyCFG::BuildPreds(){
+    preds.clear();
+    for(auto bb:*func)
+        for(auto succ:GetSuccs(bb)){
+            auto& vec=preds[succ];
+            if(std::find(vec.begin(),vec.end(),bb)==vec.end())
+                vec.push_back(bb);
+        }
+}
+
+/// @brief br 常量条件改成直接跳, br c, %x, %x 也改成 br %x, 多出来的一条 phi 记录删掉
+bool SimplifyCFG::FoldBranches(){
+    bool modified=false;
+    for(auto bb:*func){
+        auto cond=dynamic_cast<CondInst*>(bb->back());
+        if(cond==nullptr)
+            continue;
+        auto cond_val=cond->GetOperand(0);
+        auto truebb=cond->GetOperand(1)->as<BasicBlock>();
+        auto falsebb=cond->GetOperand(2)->as<BasicBlock>();
+        BasicBlock* target=nullptr;
+        if(truebb==falsebb){
+            target=truebb;
+            target->RemovePredBB(bb);
+        }
+        else if(dynamic_cast<ConstIRBoolean*>(cond_val)||dynamic_cast<ConstIRInt*>(cond_val)){
+            target=cond_val->isConstZero()?falsebb:truebb;
+            (target==truebb?falsebb:truebb)->RemovePredBB(bb);
+        }
+        else
+            continue;
+        delete cond;
+        bb->push_back(new UnCondInst(target));
+        modified=true;
+    }
+    return modified;
+}
+
+/// @brief 只有一条 br %t 的块, 让前驱直接跳到 %t
+/// @note 前驱本来就能到 %t 且 %t 有 phi 时, 两条边流进来的值可能不一样, 不动
+bool SimplifyCFG::RemoveForwardingBlocks(){
+    bool modified=false;
+    BuildPreds();
+    std::vector<BasicBlock*> blocks;
+    for(auto bb:*func)
+        blocks.push_back(bb);
+    for(auto bb:blocks){
+        if(bb==func->front()||bb->Size()!=1)
+            continue;
+        auto br=dynamic_cast<UnCondInst*>(bb->back());
+        if(br==nullptr)
+            continue;
+        auto target=br->GetOperand(0)->as<BasicBlock>();
+        if(target==bb)
+            continue;
+        auto& bbpreds=preds[bb];
+        auto& targetpreds=preds[target];
+        if(bbpreds.empty())
+            continue;
+        bool hasphi=dynamic_cast<PhiInst*>(target->front())!=nullptr;
+        if(hasphi&&std::any_of(bbpreds.begin(),bbpreds.end(),[&](BasicBlock* pred){
+            return std::find(targetpreds.begin(),targetpreds.end(),pred)!=targetpreds.end();
+        }))
+            continue;
+
+        std::vector<Use*> uses;
+        for(auto use:bb->GetUserlist())
+            uses.push_back(use);
+        for(auto use:uses)
+            use->GetUser()->RSUW(use,target);
+        for(auto inst:*target){
+            auto phi=dynamic_cast<PhiInst*>(inst);
+            if(phi==nullptr)break;
+            auto val=phi->ReturnValIn(bb);
+            phi->ModifyBlock(bb,bbpreds[0]);
+            for(int i=1;i<bbpreds.size();i++)
+                phi->updateIncoming(val,bbpreds[i]);
+        }
+        // 维护前驱表, 后面的块还要用
+        targetpreds.erase(std::remove(targetpreds.begin(),targetpreds.end(),bb),targetpreds.end());
+        for(auto pred:bbpreds)
+            if(std::find(targetpreds.begin(),targetpreds.end(),pred)==targetpreds.end())
+                targetpreds.push_back(pred);
+        preds.erase(bb);
+        delete br;
+        delete bb;
+        modified=true;
+    }
+    return modified;
+}
+
+/// @brief bb 只跳到 succ, succ 也只有 bb 一个前驱时把 succ 接到 bb 后面
+bool SimplifyCFG::MergeBlocks(){
+    bool modified=false;
+    BuildPreds();
+    std::vector<BasicBlock*> blocks;
+    for(auto bb:*func)
+        blocks.push_back(bb);
+    std::set<BasicBlock*> merged;
+    for(auto bb:blocks){
+        if(merged.find(bb)!=merged.end())
+            continue;
+        // 合并之后 bb 的结尾换成了 succ 的, 接着往下合并整条链
+        while(true){
+            auto br=dynamic_cast<UnCondInst*>(bb->back());
+            if(br==nullptr)
+                break;
+            auto succ=br->GetOperand(0)->as<BasicBlock>();
+            if(succ==bb||succ==func->front()||preds[succ].size()!=1)
+                break;
+            for(auto iter=succ->begin();iter!=succ->end();){
+                auto phi=dynamic_cast<PhiInst*>(*iter);
+                if(phi==nullptr)break;
+                ++iter;
+                Value* val=phi->PhiRecord.begin()->second.first;
+                if(val==phi)
+                    val=UndefValue::get(phi->GetType());
+                phi->RAUW(val);
+                delete phi;
+            }
+            delete br;
+            while(succ->Size()!=0){
+                auto inst=succ->front();
+                inst->EraseFromParent();
+                bb->push_back(inst);
+            }
+            for(auto next:GetSuccs(bb)){
+                for(auto inst:*next){
+                    auto phi=dynamic_cast<PhiInst*>(inst);
+                    if(phi==nullptr)break;
+                    phi->ModifyBlock(succ,bb);
+                }
+                auto& vec=preds[next];
+                std::replace(vec.begin(),vec.end(),succ,bb);
+            }
+            preds.erase(succ);
+            merged.insert(succ);
+            delete succ;
+            modified=true;
+        }
+    }
+    return modified;
+}
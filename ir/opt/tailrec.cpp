@@ -0,0 +1,150 @@
+#include "../../include/ir/opt/tailrec.hpp"
+
+bool TailRecElim::IsSelfCall(Value* val){
+    auto call=dynamic_cast<CallInst*>(val);
+    if(call==nullptr||call->GetOperand(0)!=func)
+        return false;
+    for(int i=1;i<call->Getuselist().size();i++)
+        if(PointsToFrame(call->GetOperand(i)))
+            return false;
+    return true;
+}
+
+bool TailRecElim::PointsToFrame(Value* ptr){
+    while(auto gep=dynamic_cast<GetElementPtrInst*>(ptr))
+        ptr=gep->GetOperand(0);
+    return dynamic_cast<AllocaInst*>(ptr)!=nullptr;
+}
+
+/// @brief 块末尾是不是 call; ret 或者 call; x op call; ret
+bool TailRecElim::FindSite(BasicBlock* bb,Site& site){
+    auto ret=dynamic_cast<RetInst*>(bb->back());
+    if(ret==nullptr||bb->Size()<2)
+        return false;
+    mylist<BasicBlock,User>::iterator iter(ret);
+    --iter;
+    auto prev=*iter;
+    site={nullptr,nullptr,ret};
+    Value* retval=ret->Getuselist().empty()?nullptr:ret->GetOperand(0);
+    if(IsSelfCall(prev)){
+        if(retval!=nullptr&&retval!=prev&&!retval->isUndefVal())
+            return false;
+        // 返回值没用上时 call 可能还有别的 user
+        if(prev->GetUserListSize()!=(retval==prev?1:0))
+            return false;
+        site.call=dynamic_cast<CallInst*>(prev);
+        return true;
+    }
+    auto binary=dynamic_cast<BinaryInst*>(prev);
+    if(binary==nullptr||retval!=binary||binary->GetUserListSize()!=1||binary->GetType()!=IntType::NewIntTypeGet())
+        return false;
+    if(binary->getopration()!=BinaryInst::Op_Add&&binary->getopration()!=BinaryInst::Op_Mul)
+        return false;
+    if(iter==bb->begin())
+        return false;
+    --iter;
+    auto call=*iter;
+    if(!IsSelfCall(call)||call->GetUserListSize()!=1)
+        return false;
+    if(binary->GetOperand(0)!=call&&binary->GetOperand(1)!=call)
+        return false;
+    if(binary->GetOperand(0)==binary->GetOperand(1))
+        return false;
+    site.call=dynamic_cast<CallInst*>(call);
+    site.accum=binary;
+    return true;
+}
+
+bool TailRecElim::run(Function* f){
+    func=f;
+    std::vector<Site> sites;
+    std::vector<RetInst*> rets;
+    bool hasop=false;
+    BinaryInst::Operation op;
+    for(auto bb:*func){
+        Site site;
+        if(FindSite(bb,site)){
+            // 加和乘混在一起时累加值没法合并, 只留第一种
+            if(site.accum!=nullptr){
+                if(hasop&&site.accum->getopration()!=op){
+                    rets.push_back(site.ret);
+                    continue;
+                }
+                hasop=true;
+                op=site.accum->getopration();
+            }
+            sites.push_back(site);
+        }
+        else if(auto ret=dynamic_cast<RetInst*>(bb->back()))
+            rets.push_back(ret);
+    }
+    if(sites.empty())
+        return false;
+
+    // 新的入口块只放 alloca, 原来的入口变成循环头
+    auto header=func->front();
+    auto entry=new BasicBlock();
+    mylist<Function,BasicBlock>::iterator(header).insert_before(entry);
+    std::vector<User*> allocas;
+    for(auto inst:*header)
+        if(dynamic_cast<AllocaInst*>(inst))
+            allocas.push_back(inst);
+    for(auto alloca:allocas){
+        alloca->EraseFromParent();
+        entry->push_back(alloca);
+    }
+    entry->push_back(new UnCondInst(header));
+
+    std::vector<PhiInst*> phis;
+    auto& params=func->GetParams();
+    for(auto iter=params.rbegin();iter!=params.rend();++iter){
+        auto param=iter->get();
+        auto phi=new PhiInst(param->GetType());
+        header->push_front(phi);
+        param->RAUW(phi);
+        phi->updateIncoming(param,entry);
+        phis.insert(phis.begin(),phi);
+    }
+    PhiInst* acc=nullptr;
+    if(hasop){
+        acc=new PhiInst(IntType::NewIntTypeGet());
+        header->push_front(acc);
+        acc->updateIncoming(ConstIRInt::GetNewConstant(op==BinaryInst::Op_Add?0:1),entry);
+        // 不是尾调用的 ret 返回 acc op val
+        for(auto ret:rets){
+            if(ret->Getuselist().empty()||ret->GetOperand(0)->isUndefVal())
+                continue;
+            auto cint=dynamic_cast<ConstIRInt*>(ret->GetOperand(0));
+            if(cint!=nullptr&&cint->GetVal()==(op==BinaryInst::Op_Add?0:1)){
+                ret->RSUW(0,acc);
+                continue;
+            }
+            auto val=new BinaryInst(acc,op,ret->GetOperand(0));
+            mylist<BasicBlock,User>::iterator(ret).insert_before(val);
+            ret->RSUW(0,val);
+        }
+    }
+
+    for(auto& site:sites){
+        auto bb=site.ret->GetParent();
+        for(int i=0;i<phis.size();i++)
+            phis[i]->updateIncoming(site.call->GetOperand(i+1),bb);
+        BinaryInst* next=nullptr;
+        if(site.accum!=nullptr){
+            auto other=site.accum->GetOperand(0)==site.call?site.accum->GetOperand(1):site.accum->GetOperand(0);
+            next=new BinaryInst(acc,op,other);
+        }
+        delete site.ret;
+        if(site.accum!=nullptr)
+            delete site.accum;
+        delete site.call;
+        if(acc!=nullptr){
+            if(next!=nullptr)
+                bb->push_back(next);
+            acc->updateIncoming(next!=nullptr?(Value*)next:acc,bb);
+        }
+        bb->push_back(new UnCondInst(header));
+    }
+    func->CFGChanged();
+    return true;
+}
@@ -0,0 +1,254 @@
+#include "../../include/ir/opt/unroll.hpp"
+#include <climits>
+
+bool LoopUnroll::run(Function* f){
+    func=f;
+    indvar=AM.get<InductionVar>(func);
+    auto loopinfo=AM.get<LoopInfo>(func);
+    // 展开只改动 preheader 的跳转和循环自身, 不同的最内层循环互不影响, 先收集再一起改
+    std::vector<Candidate> candidates;
+    for(auto loop:loopinfo->GetLoops()){
+        Candidate cand;
+        if(loop->GetSubLoops().empty()&&Analyze(loop,cand))
+            candidates.push_back(cand);
+    }
+    bool modified=false;
+    for(auto& cand:candidates){
+        int trip=GetTripCount(cand);
+        if(trip>0&&trip<=MaxFullTrip&&trip*cand.size<=FullBudget){
+            FullUnroll(cand,trip);
+            modified=true;
+            continue;
+        }
+        // 只跑几次的循环展开了也进不去主循环
+        if(trip>=0&&trip<MaxFactor*2)
+            continue;
+        int factor=std::min(MaxFactor,PartialBudget/cand.size);
+        if(factor<2)
+            continue;
+        modified|=PartialUnroll(cand,factor);
+    }
+    if(modified)
+        func->CFGChanged();
+    return modified;
+}
+
+bool LoopUnroll::Analyze(Loop* loop,Candidate& cand){
+    auto header=loop->GetHeader();
+    if(loop->GetPreheader()==nullptr||loop->GetLatches().size()!=1||loop->GetExits().size()!=1)
+        return false;
+    if(loop->GetExiting().size()!=1||loop->GetExiting()[0]!=header)
+        return false;
+    if(dynamic_cast<UnCondInst*>(loop->GetLatches()[0]->back())==nullptr)
+        return false;
+
+    auto br=dynamic_cast<CondInst*>(header->back());
+    if(br==nullptr||!loop->Contains(br->GetOperand(1)->as<BasicBlock>()))
+        return false;
+    auto cmp=dynamic_cast<BinaryInst*>(br->GetOperand(0));
+    if(cmp==nullptr||cmp->GetParent()!=header||cmp->GetUserListSize()!=1)
+        return false;
+    for(auto inst:*header)
+        if(dynamic_cast<PhiInst*>(inst)==nullptr&&inst!=cmp&&inst!=br)
+            return false;
+
+    // 统一成 iv pred bound
+    auto pred=cmp->getopration();
+    auto iv=indvar->GetIndVar(cmp->GetOperand(0));
+    auto bound=cmp->GetOperand(1);
+    if(iv==nullptr){
+        iv=indvar->GetIndVar(cmp->GetOperand(1));
+        bound=cmp->GetOperand(0);
+        switch(pred){
+            case BinaryInst::Op_L:pred=BinaryInst::Op_G;break;
+            case BinaryInst::Op_LE:pred=BinaryInst::Op_GE;break;
+            case BinaryInst::Op_G:pred=BinaryInst::Op_L;break;
+            case BinaryInst::Op_GE:pred=BinaryInst::Op_LE;break;
+            default:break;
+        }
+    }
+    if(iv==nullptr||iv->loop!=loop)
+        return false;
+    // 只认单调逼近边界的比较, 这样主循环的判断成立时后面几份也一定成立
+    bool up=(pred==BinaryInst::Op_L||pred==BinaryInst::Op_LE)&&iv->step>0;
+    bool down=(pred==BinaryInst::Op_G||pred==BinaryInst::Op_GE)&&iv->step<0;
+    if(!up&&!down)
+        return false;
+    if(auto inst=dynamic_cast<User*>(bound))
+        if(inst->GetParent()!=nullptr&&loop->Contains(inst->GetParent()))
+            return false;
+
+    cand.loop=loop;
+    cand.iv=iv;
+    cand.cmp=cmp;
+    cand.pred=pred;
+    cand.bound=bound;
+    cand.body.clear();
+    cand.size=0;
+    auto entry=br->GetOperand(1)->as<BasicBlock>();
+    if(dynamic_cast<PhiInst*>(entry->front()))
+        return false;
+    cand.body.push_back(entry);
+    for(auto bb:loop->GetBlocks())
+        if(bb!=header&&bb!=entry)
+            cand.body.push_back(bb);
+    for(auto bb:cand.body)
+        cand.size+=bb->Size();
+    return true;
+}
+
+int LoopUnroll::GetTripCount(Candidate& cand){
+    auto init=dynamic_cast<ConstIRInt*>(cand.iv->init);
+    auto bound=dynamic_cast<ConstIRInt*>(cand.bound);
+    if(init==nullptr||bound==nullptr)
+        return -1;
+    long long x=init->GetVal(),b=bound->GetVal(),step=cand.iv->step;
+    auto Holds=[&](){
+        switch(cand.pred){
+            case BinaryInst::Op_L:return x<b;
+            case BinaryInst::Op_LE:return x<=b;
+            case BinaryInst::Op_G:return x>b;
+            default:return x>=b;
+        }
+    };
+    int trip=0;
+    // 数到 MaxFactor*2 以上就够判断要不要完全展开了, 次数太多按未知处理
+    while(Holds()){
+        if(++trip>std::max(MaxFullTrip,MaxFactor*2))
+            return -1;
+        x+=step;
+        if(x<INT_MIN||x>INT_MAX)
+            return -1;
+    }
+    return trip;
+}
+
+void LoopUnroll::ReplaceIncoming(PhiInst* phi,BasicBlock* from,Value* val,BasicBlock* to){
+    for(auto& [index,rec]:phi->PhiRecord){
+        if(rec.second!=from)
+            continue;
+        // Del_Incomes 按值删 use, UseToRecord 和 PhiRecord 未必对得上, 这里也按值找
+        for(auto& use:phi->Getuselist())
+            if(use->GetValue()==rec.first){
+                phi->RSUW(use.get(),val);
+                break;
+            }
+        rec=std::make_pair(val,to);
+        return;
+    }
+}
+
+BasicBlock* LoopUnroll::CloneBody(Candidate& cand,int count,std::unordered_map<PhiInst*,Value*>& init,BasicBlock* before,BasicBlock*& entry){
+    auto loop=cand.loop;
+    auto header=loop->GetHeader();
+    auto latch=loop->GetLatches()[0];
+    // 循环外的值和 header 原样保留, 不能让 clone 顺着操作数复制出去
+    std::unordered_map<Operand,Operand> outside;
+    outside[header]=header;
+    for(auto bb:cand.body)
+        for(auto inst:*bb)
+            for(auto& use:inst->Getuselist()){
+                auto val=use->GetValue();
+                if(auto def=dynamic_cast<User*>(val))
+                    if(def->GetParent()!=nullptr&&loop->Contains(def->GetParent()))
+                        continue;
+                if(auto bb=dynamic_cast<BasicBlock*>(val))
+                    if(loop->Contains(bb))
+                        continue;
+                outside[val]=val;
+            }
+
+    BasicBlock* prevlatch=nullptr;
+    for(int i=0;i<count;i++){
+        auto mapping=outside;
+        for(auto& [phi,val]:init)
+            mapping[phi]=val;
+        for(auto bb:cand.body){
+            auto clone=bb->clone(mapping);
+            mylist<Function,BasicBlock>::iterator(before).insert_before(clone);
+        }
+        auto first=mapping[cand.body[0]]->as<BasicBlock>();
+        if(prevlatch==nullptr)
+            entry=first;
+        else
+            prevlatch->back()->RSUW(0,first);
+        prevlatch=mapping[latch]->as<BasicBlock>();
+        // 下一份里 header phi 的值是这一份 latch 流回去的值, 要在同一个映射下一起算
+        std::unordered_map<PhiInst*,Value*> next;
+        for(auto& [phi,val]:init){
+            auto back=phi->ReturnValIn(latch);
+            auto iter=mapping.find(back);
+            next[phi]=iter!=mapping.end()?iter->second:back;
+        }
+        init.swap(next);
+    }
+    return prevlatch;
+}
+
+/// @brief preheader -> 第 1 份 -> ... -> 第 trip 份 -> header, header 的 phi 改从最后一份流入
+void LoopUnroll::FullUnroll(Candidate& cand,int trip){
+    auto loop=cand.loop;
+    auto header=loop->GetHeader();
+    auto preheader=loop->GetPreheader();
+    std::unordered_map<PhiInst*,Value*> init;
+    for(auto inst:*header)
+        if(auto phi=dynamic_cast<PhiInst*>(inst))
+            init[phi]=phi->ReturnValIn(preheader);
+    BasicBlock* entry=nullptr;
+    auto last=CloneBody(cand,trip,init,header,entry);
+    for(auto& [phi,val]:init)
+        ReplaceIncoming(phi,preheader,val,last);
+    preheader->back()->RSUW(0,entry);
+}
+
+/// @brief 主循环 newheader: phi, iv pred bound-(factor-1)*step, 成立时跑 factor 份循环体, 否则进原来的循环收尾
+/// @note bound-(factor-1)*step 在 preheader 里算, bound 贴着 INT_MIN/INT_MAX 时会回绕, 这种循环本来也跑不了几次, 常数边界时直接放弃
+bool LoopUnroll::PartialUnroll(Candidate& cand,int factor){
+    auto loop=cand.loop;
+    auto header=loop->GetHeader();
+    auto preheader=loop->GetPreheader();
+    auto latch=loop->GetLatches()[0];
+    long long delta=(long long)(factor-1)*cand.iv->step;
+    if(delta<INT_MIN||delta>INT_MAX)
+        return false;
+
+    Value* limit=nullptr;
+    if(auto cint=dynamic_cast<ConstIRInt*>(cand.bound)){
+        long long val=cint->GetVal()-delta;
+        if(val<INT_MIN||val>INT_MAX)
+            return false;
+        limit=ConstIRInt::GetNewConstant(val);
+    }
+    else{
+        auto sub=new BinaryInst(cand.bound,BinaryInst::Op_Sub,ConstIRInt::GetNewConstant(delta));
+        mylist<BasicBlock,User>::iterator(preheader->back()).insert_before(sub);
+        limit=sub;
+    }
+
+    auto newheader=new BasicBlock();
+    mylist<Function,BasicBlock>::iterator(header).insert_before(newheader);
+    std::unordered_map<PhiInst*,Value*> init;
+    std::vector<std::pair<PhiInst*,PhiInst*>> phis;
+    for(auto inst:*header){
+        auto phi=dynamic_cast<PhiInst*>(inst);
+        if(phi==nullptr)break;
+        auto newphi=new PhiInst(phi->GetType());
+        newheader->push_back(newphi);
+        newphi->updateIncoming(phi->ReturnValIn(preheader),preheader);
+        init[phi]=newphi;
+        phis.emplace_back(phi,newphi);
+    }
+    auto cmp=new BinaryInst(init[cand.iv->phi],cand.pred,limit);
+    newheader->push_back(cmp);
+
+    BasicBlock* entry=nullptr;
+    auto last=CloneBody(cand,factor,init,header,entry);
+    last->back()->RSUW(0,newheader);
+    newheader->push_back(new CondInst(cmp,entry,header));
+    for(auto [phi,newphi]:phis){
+        newphi->updateIncoming(init[phi],last);
+        ReplaceIncoming(phi,preheader,newphi,newheader);
+    }
+    preheader->back()->RSUW(0,newheader);
+    return true;
+}
@@ -1,6 +1,7 @@
 #include "../include/lib/AST_NODE.hpp"
 #include "../include/lib/TypeTrans.hpp"
 #include <algorithm>
+#include <functional>
 LocType::LocType():begin(0),end(0){
 }
 
@@ -241,6 +242,71 @@ void BaseDef::print(int x){
 
 VarDef::VarDef(std::string _id,Exps* _ad,InitVal* _iv):BaseDef(_id,_ad,_iv){}
 
+/// @brief 按下标顺序遍历数组的每个元素, 没写出来的元素给 nullptr(即 0)
+static void VisitElements(Type* tp,Initializer* init,std::vector<int>& index,const std::function<void(std::vector<int>&,Operand)>& visit){
+    auto arr=dynamic_cast<ArrayType*>(tp);
+    for(int i=0;i<arr->GetNumEle();i++){
+        index.push_back(i);
+        Operand ele=(init!=nullptr&&i<init->size())?(*init)[i]:nullptr;
+        if(arr->GetSubType()->GetTypeEnum()==IR_ARRAY)
+            VisitElements(arr->GetSubType(),dynamic_cast<Initializer*>(ele),index,visit);
+        else visit(index,ele);
+        index.pop_back();
+    }
+}
+
+/// @brief 局部数组初始化, 按大小和非零元素的密度选方式
+/// @note 小数组直接逐个 store; 非零元素不多的先 memset 清零再 store 非零元素;
+/// 常量多的才从常量模板 memcpy, 再补上非常量元素
+static void InitLocalArray(BasicBlock* bb,AllocaInst* alloca,Type* tp,Initializer* init,const std::string& name){
+    const size_t InlineBytes=64;
+    size_t total=tp->get_size()/4,nonzero=0;
+    std::vector<int> index;
+    VisitElements(tp,init,index,[&](std::vector<int>&,Operand ele){
+        if(ele!=nullptr&&!ele->isConstZero())nonzero++;
+    });
+    auto store=[&](std::vector<int>& index,Operand ele){
+        if(ele==nullptr){
+            if(dynamic_cast<HasSubType*>(tp)->get_baseType()->GetTypeEnum()==IR_Value_INT)
+                ele=ConstIRInt::GetNewConstant();
+            else ele=ConstIRFloat::GetNewConstant();
+        }
+        auto gep=dynamic_cast<GetElementPtrInst*>(bb->GenerateGEPInst(alloca));
+        gep->add_use(ConstIRInt::GetNewConstant());
+        for(auto j:index)
+            gep->add_use(ConstIRInt::GetNewConstant(j));
+        bb->GenerateStoreInst(ele,gep);
+    };
+    if(tp->get_size()<=InlineBytes){
+        VisitElements(tp,init,index,store);
+        return;
+    }
+    if(nonzero*4<=total){
+        std::vector<Operand> args;
+        args.push_back(alloca);
+        args.push_back(ConstIRInt::GetNewConstant());
+        args.push_back(ConstIRInt::GetNewConstant(tp->get_size()));
+        args.push_back(ConstIRBoolean::GetNewConstant(false));
+        /*call void @llvm.memset.p0.i32(ptr <dst>, i8 0, i32 <num_bytes>, i1 false)*/
+        bb->GenerateCallInst("llvm.memset.p0.i32",args,0);
+        VisitElements(tp,init,index,[&](std::vector<int>& index,Operand ele){
+            if(ele!=nullptr&&!ele->isConstZero())store(index,ele);
+        });
+        return;
+    }
+    std::vector<Operand> args;
+    auto src=new Variable(Variable::Constant,tp,"");
+    src->add_use(init);
+    args.push_back(alloca);//des
+    args.push_back(src);
+    args.push_back(ConstIRInt::GetNewConstant(tp->get_size()));
+    args.push_back(ConstIRBoolean::GetNewConstant(false));
+    /*call void @llvm.memcpy.p0.p0.i32(ptr <1>, ptr <2>, i64 <num_bytes>, i1 false)*/
+    bb->GenerateCallInst("llvm.memcpy.p0.p0.i32",args,0);
+    std::vector<int> temp;
+    init->Var2Store(bb,name,temp);
+}
+
 BasicBlock* BaseDef::GetInst(GetInstState state){
     if(array_descripters!=nullptr)
     {
@@ -250,17 +316,7 @@ BasicBlock* BaseDef::GetInst(GetInstState state){
         {
             Operand init=civ->GetOperand(tmp,state.current_building);
             // if(init==nullptr)return state.current_building;
-            std::vector<Operand> args;
-            auto src=new Variable(Variable::Constant,tmp,"");
-            src->add_use(init);
-            args.push_back(alloca);//des
-            args.push_back(src);
-            args.push_back(ConstIRInt::GetNewConstant(tmp->get_size()));
-            args.push_back(ConstIRBoolean::GetNewConstant(false));
-            /*call void @llvm.memcpy.p0.p0.i32(ptr <1>, ptr <2>, i64 <num_bytes>, i1 false)*/
-            state.current_building->GenerateCallInst("llvm.memcpy.p0.p0.i32",args,0);
-            std::vector<int> temp;
-            dynamic_cast<Initializer*>(init)->Var2Store(state.current_building,ID,temp);
+            InitLocalArray(state.current_building,alloca,tmp,dynamic_cast<Initializer*>(init),ID);
         }
     }
     else
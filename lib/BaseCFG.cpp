@@ -139,8 +139,12 @@ User *User::clone(std::unordered_map<Operand, Operand> &mapping) {
   assert(mapping.find(this) != mapping.end() && "User not copied!");
   auto to = dynamic_cast<User *>(mapping[this]);
   assert(to != nullptr && "It is not a User!Impossible");
-  for (auto &use : uselist)
-    to->add_use(use->GetValue()->clone(mapping));
+  for (auto &use : uselist) {
+    // 已经映射过的值(比如内联时的形参->实参)直接用, 不再走各自的 clone
+    auto val = use->GetValue();
+    auto iter = mapping.find(val);
+    to->add_use(iter != mapping.end() ? iter->second : val->clone(mapping));
+  }
   return to;
 }
 
@@ -194,7 +198,8 @@ bool User::HasSideEffect() {
         name == "getfarray" || name == "putint" || name == "putfloat" ||
         name == "putarray" || name == "putfarray" || name == "putf" ||
         name == "getarray" || name == "putch" || name == "_sysy_starttime" ||
-        name == "_sysy_stoptime" || name == "llvm.memcpy.p0.p0.i32")
+        name == "_sysy_stoptime" || name == "llvm.memcpy.p0.p0.i32" ||
+        name == "llvm.memset.p0.i32")
       return true;
     Function *func =
         dynamic_cast<Function *>(this->Getuselist()[0]->GetValue());
@@ -396,7 +396,7 @@ void BinaryInst::print() {
     std::cout << "Or ";
     break;
   case BinaryInst::Op_E:
-    if (uselist[0]->GetValue()->GetTypeEnum() == IR_Value_INT)
+    if (uselist[0]->GetValue()->GetTypeEnum() != IR_Value_Float)
       std::cout << "i";
     else
       std::cout << "f";
@@ -406,7 +406,7 @@ void BinaryInst::print() {
     std::cout << "eq ";
     break;
   case BinaryInst::Op_NE:
-    if (uselist[0]->GetValue()->GetTypeEnum() == IR_Value_INT)
+    if (uselist[0]->GetValue()->GetTypeEnum() != IR_Value_Float)
       std::cout << "i";
     else
       std::cout << "f";
@@ -416,7 +416,7 @@ void BinaryInst::print() {
     std::cout << "ne ";
     break;
   case BinaryInst::Op_G:
-    if (uselist[0]->GetValue()->GetTypeEnum() == IR_Value_INT)
+    if (uselist[0]->GetValue()->GetTypeEnum() != IR_Value_Float)
       std::cout << "i";
     else
       std::cout << "f";
@@ -427,7 +427,7 @@ void BinaryInst::print() {
       std::cout << "sgt ";
     break;
   case BinaryInst::Op_GE:
-    if (uselist[0]->GetValue()->GetTypeEnum() == IR_Value_INT)
+    if (uselist[0]->GetValue()->GetTypeEnum() != IR_Value_Float)
       std::cout << "i";
     else
       std::cout << "f";
@@ -438,7 +438,7 @@ void BinaryInst::print() {
       std::cout << "sge ";
     break;
   case BinaryInst::Op_L:
-    if (uselist[0]->GetValue()->GetTypeEnum() == IR_Value_INT)
+    if (uselist[0]->GetValue()->GetTypeEnum() != IR_Value_Float)
       std::cout << "i";
     else
       std::cout << "f";
@@ -449,7 +449,7 @@ void BinaryInst::print() {
       std::cout << "slt ";
     break;
   case BinaryInst::Op_LE:
-    if (uselist[0]->GetValue()->GetTypeEnum() == IR_Value_INT)
+    if (uselist[0]->GetValue()->GetTypeEnum() != IR_Value_Float)
       std::cout << "i";
     else
       std::cout << "f";
@@ -516,6 +516,12 @@ void Variable::print() {
   std::cout << '\n';
 }
 
+Variable *Variable::clone(std::unordered_map<Operand, Operand> &mapping) {
+  // 全局变量和常量数组整个模块只有一份, 形参要由调用者提前放进 mapping
+  assert(isGlobal() && "Param Should Be Mapped Before Clone");
+  return this;
+}
+
 bool Variable::isGlobal() {
   if (usage == Param)
     return false;
@@ -769,6 +775,7 @@ BasicBlock *BasicBlock::SplitAt(User *inst) {
 
   auto [left, right] = split(inst, back());
   tmp->collect(left, right);
+  GetParent()->CFGChanged();
   return tmp;
 }
 
@@ -810,6 +817,7 @@ void Function::InsertAlloca(AllocaInst *ptr) { front()->push_back(ptr); }
 
 void Function::InsertBlock(BasicBlock *pred, BasicBlock *succ,
                            BasicBlock *insert) {
+  CFGChanged();
   if (auto condition = pred->back()) {
     if (auto cond = dynamic_cast<CondInst *>(condition)) {
       for (int i = 1; i <= 2; i++) {
@@ -833,6 +841,7 @@ void Function::InsertBlock(BasicBlock *pred, BasicBlock *succ,
 }
 
 void Function::InsertBlock(BasicBlock *curr, BasicBlock *insert) {
+  CFGChanged();
   insert->GenerateUnCondInst(curr);
   // this->push_back(insert);
   insert->num = this->bb_num++;
@@ -878,6 +887,10 @@ BuildInFunction *BuildInFunction::GetBuildInFunction(std::string _id) {
       return VoidType::NewVoidTypeGet();
     if (_id == "memcpy@plt")
       return VoidType::NewVoidTypeGet();
+    if (_id == "llvm.memset.p0.i32")
+      return VoidType::NewVoidTypeGet();
+    if (_id == "memset@plt")
+      return VoidType::NewVoidTypeGet();
     assert(0);
   };
   if (mp.find(_id) == mp.end()) {
@@ -904,59 +917,30 @@ bool BasicBlock::EndWithBranch() {
     return 0;
 }
 
+/// @brief 删掉 phi 里来自 pred 的入边, 只剩一条入边的 phi 直接换成那个值
 void BasicBlock::RemovePredBB(BasicBlock *pred) {
-  //不能自己删除自己
-  if (pred == this)
-    return;
-  for (auto iter = this->begin(); iter != this->end(); ++iter) {
-    auto inst = *iter;
-    if (auto phi = dynamic_cast<PhiInst *>(this->front())) {
-      auto tmp = std::find_if(
-          phi->PhiRecord.begin(), phi->PhiRecord.end(),
-          [pred](const std::pair<int, std::pair<Value *, BasicBlock *>> &ele) {
-            return ele.second.second == pred;
-          });
-      if (tmp != phi->PhiRecord.end()) {
-        phi->Del_Incomes(tmp->first);
-        phi->FormatPhi();
-      }
-      if (phi->PhiRecord.size() == 1) {
-        //如果删除后还剩一个operand,检查是否是循环
-        BasicBlock *b = phi->PhiRecord.begin()->second.second;
-        if (b == this) {
-          phi->RAUW(UndefValue::get(phi->GetType()));
-          delete phi;
-        } else {
-
-          Value *repl = (*(phi->PhiRecord.begin())).second.first;
-          // avoid situation like this:
-          //   %54 =phi [%23,%1]
-          //   %.23 = add i32 %.54, 2
-          // After RAUW:  %.23 = add i32 %.23, 2; which is not SSA form
-          // for (auto use : phi->GetUserlist()) {
-          //   auto user = use->GetUser();
-          //   if (user->GetDef() != nullptr && user->GetDef() == repl) {
-          //     auto New = user->CloneInst();
-          //     for (auto iter = user->GetParent()->begin();
-          //          iter != user->GetParent()->end(); ++iter) {
-          //       if (*iter == user) {
-          //         iter.insert_before(New);
-          //         break;
-          //       }
-          //     }
-          //     user->RAUW(New);
-          //     repl=(*(phi->PhiRecord.begin())).second.first;
-          //     delete user;
-          //   }
-          // }
-          phi->RAUW(repl);
-          // phi->ClearRelation();
-          // phi->EraseFromParent();
-          delete phi;
-        }
-      }
-    } else
+  for (auto iter = this->begin(); iter != this->end();) {
+    auto phi = dynamic_cast<PhiInst *>(*iter);
+    if (phi == nullptr)
       return;
+    ++iter;
+    auto tmp = std::find_if(
+        phi->PhiRecord.begin(), phi->PhiRecord.end(),
+        [pred](const std::pair<int, std::pair<Value *, BasicBlock *>> &ele) {
+          return ele.second.second == pred;
+        });
+    if (tmp != phi->PhiRecord.end()) {
+      phi->Del_Incomes(tmp->first);
+      phi->FormatPhi();
+    }
+    if (phi->PhiRecord.size() == 1) {
+      Value *repl = phi->PhiRecord.begin()->second.first;
+      // 只剩自己流回自己的 phi 说明这里已经不可达了
+      if (repl == phi)
+        repl = UndefValue::get(phi->GetType());
+      phi->RAUW(repl);
+      delete phi;
+    }
   }
 }
 void BasicBlock::GenerateCondInst(Operand condi, BasicBlock *is_true,
@@ -1014,6 +998,8 @@ Operand BasicBlock::GenerateCallInst(std::string id, std::vector<Operand> args,
       return true;
     if (_id == "llvm.memcpy.p0.p0.i32")
       return true;
+    if (_id == "llvm.memset.p0.i32")
+      return true;
     return false;
   };
 
@@ -1334,9 +1320,10 @@ void Function::init_visited_block() {
   for (auto bb : bbs)
     bb->visited = false;
 }
+/// @note bbs 只有前端建块时维护, pass 新建的块只在链表里, 所以这里遍历链表
 void Function::init_reach_block() {
-  for (auto bb : bbs)
-    bb->reachable = true;
+  for (auto bb : *this)
+    bb->reachable = false;
 }
 
 void Function::add_block(BasicBlock *bb) { push_back(bb); }
@@ -1348,6 +1335,26 @@ std::vector<std::unique_ptr<Value>> &Function::GetParams() { return params; }
 //         call_back(i.get());
 // }
 void Module::Test() {
+  std::set<std::string> declared;
+  for (auto &func : ls)
+    for (auto bb : *func)
+      for (auto inst : *bb) {
+        auto call = dynamic_cast<CallInst *>(inst);
+        if (call == nullptr)
+          continue;
+        auto callee = dynamic_cast<BuildInFunction *>(call->GetOperand(0));
+        if (callee == nullptr || !declared.insert(callee->GetName()).second)
+          continue;
+        std::cout << "declare ";
+        callee->GetType()->print();
+        std::cout << " @" << callee->GetName() << "(";
+        for (int i = 1; i < call->Getuselist().size(); i++) {
+          call->GetOperand(i)->GetType()->print();
+          if (i + 1 != call->Getuselist().size())
+            std::cout << ", ";
+        }
+        std::cout << ")\n";
+      }
   for (auto &i : globalvaribleptr)
     i->print();
   for (auto &i : ls)
@@ -1429,7 +1436,9 @@ PhiInst *PhiInst::clone(std::unordered_map<Operand, Operand> &mapping) {
   auto to = new PhiInst(GetType());
   mapping[this] = to;
   for (auto &[i, data] : PhiRecord) {
-    to->updateIncoming(data.first->clone(mapping), data.second->clone(mapping));
+    auto iter = mapping.find(data.first);
+    auto val = iter != mapping.end() ? iter->second : data.first->clone(mapping);
+    to->updateIncoming(val, data.second->clone(mapping));
   }
   return to;
 }
\ No newline at end of file
@@ -15,12 +15,13 @@ bool Trival::check_builtin(std::string id){
     if(id=="stoptime")return true;
     if(id=="putf")return true;
     if(id=="llvm.memcpy.p0.p0.i32")return true;
+    if(id=="llvm.memset.p0.i32")return true;
     return false;
 }
 
 User* Trival::GenerateCallInst(std::string id,std::vector<Operand> args){
     if(check_builtin(id)){
-        if(id!="llvm.memcpy.p0.p0.i32")
+        if(id!="llvm.memcpy.p0.p0.i32"&&id!="llvm.memset.p0.i32")
             assert(0&&"Do not supported here");
         auto tmp=new CallInst(BuildInFunction::GetBuildInFunction(id),args,"");
         return tmp;
@@ -61,6 +62,16 @@ CallInst* Trival::BuildInTransform(CallInst* inst){
         delete inst;
         return tmp;
     }
+    if(inst->GetOperand(0)->GetName()=="llvm.memset.p0.i32"){
+        auto args=std::vector<Operand>();
+        args.push_back(inst->GetOperand(1));
+        args.push_back(inst->GetOperand(2));
+        args.push_back(inst->GetOperand(3));
+        auto tmp=new CallInst(BuildInFunction::GetBuildInFunction("memset@plt"),args,"");
+        inst->FullReplace(tmp);
+        delete inst;
+        return tmp;
+    }
     // std::cerr<<inst->GetOperand(0)->GetName()<<'\n';
     return inst;
 }
\ No newline at end of file
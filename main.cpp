@@ -2,40 +2,82 @@
 #include "./include/ir/opt/New_passManager.hpp"
 #include "./include/backend/RISCVLowering.hpp"
 #include "./include/yacc/parser.hpp"
+#include <getopt.h>
 
 extern FILE *yyin;
 extern int optind, opterr, optopt;
-extern char *optargi;
-
-void copyFile(const std::string &sourcePath,
-              const std::string &destinationPath) {
-  std::ifstream source(sourcePath, std::ios::binary);
-  std::ofstream destination(destinationPath, std::ios::binary);
-  destination << source.rdbuf();
-}
+extern char *optarg;
 
 int main(int argc, char **argv) {
-  std::string output_path = argv[1];
-  output_path += ".ll";
+  // compiler [-S|-c] [-o output.s] [-O0|-O1|-O2] [--emit-llvm] input.sy
+  std::string asmoutput_path;
+  PassManager::OptLevel level = PassManager::O0;
+  bool emit_llvm = false;
+  // -c: 直接出 .o, 不经过汇编器
+  bool emit_object = false;
+  static const option long_options[] = {{"emit-llvm", no_argument, nullptr, 'L'},
+                                        {nullptr, 0, nullptr, 0}};
+  int opt;
+  while ((opt = getopt_long(argc, argv, "Sco:O::", long_options, nullptr)) !=
+         -1) {
+    switch (opt) {
+    case 'S':
+      emit_object = false;
+      break;
+    case 'c':
+      emit_object = true;
+      break;
+    case 'L':
+      emit_llvm = true;
+      break;
+    case 'o':
+      asmoutput_path = optarg;
+      break;
+    case 'O':
+      level = PassManager::ParseOptLevel(optarg);
+      break;
+    default:
+      std::cerr << "Usage: " << argv[0]
+                << " [-S|-c] [-o output.s] [-O0|-O1|-O2] [--emit-llvm] input.sy\n";
+      return 1;
+    }
+  }
+  if (optind >= argc) {
+    std::cerr << "No Input File\n";
+    return 1;
+  }
+  std::string input_path = argv[optind];
+  std::string output_path = input_path + ".ll";
 
-  std::string filename = argv[1];
+  std::string filename = input_path;
   size_t lastSlashPos = filename.find_last_of("/\\") + 1;
   filename = filename.substr(lastSlashPos);
 
-  std::string asmoutput_path = argv[1];
-  size_t lastPointPos = asmoutput_path.find_last_of(".");
-  asmoutput_path = asmoutput_path.substr(0, lastPointPos) + ".s";
+  if (asmoutput_path.empty()) {
+    asmoutput_path = input_path;
+    size_t lastPointPos = asmoutput_path.find_last_of(".");
+    asmoutput_path = asmoutput_path.substr(0, lastPointPos) +
+                     (emit_object ? ".o" : ".s");
+  }
 
-  freopen(output_path.c_str(), "a", stdout);
-  copyFile("runtime.ll", output_path);
-  yyin = fopen(argv[1], "r");
+  yyin = fopen(input_path.c_str(), "r");
   yy::parser parse;
   parse();
   Singleton<CompUnit *>()->codegen();
-  freopen(asmoutput_path.c_str(), "w", stdout);
-  RISCVModuleLowering RISCVAsm;
+  PassManager PM(level);
+  // -O0/-O1 要的是编译快, 用线性扫描; -O2 才上图着色
+  RegAllocImpl::allocator = level == PassManager::O2
+                                ? RegAllocImpl::GraphColoring
+                                : RegAllocImpl::LinearScanning;
+  PM.run(&Singleton<Module>());
+  // 优化后的 IR 只在要的时候打印, 后端还会改 IR, 所以放在 lowering 之前
+  if (emit_llvm) {
+    std::ofstream ll(output_path);
+    auto buf = std::cout.rdbuf(ll.rdbuf());
+    Singleton<Module>().Test();
+    std::cout.rdbuf(buf);
+  }
+  RISCVModuleLowering RISCVAsm(asmoutput_path, emit_object);
   RISCVAsm.run(&Singleton<Module>());
-  fflush(stdout);
-  fclose(stdout);
   return 0;
 }
\ No newline at end of file
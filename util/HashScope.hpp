@@ -1,14 +1,29 @@
 #pragma once
 #include <cassert>
 #include <vector>
+#include <algorithm>
+#include <unordered_map>
 #include "../include/lib/CFG.hpp"
 namespace InstHashTool{
+    // add mul and or eq ne 交换操作数结果不变
+    inline bool IsCommutative(User::OpID id)
+    {
+        return id == User::OpID::Add || id == User::OpID::Mul || id == User::OpID::And ||
+               id == User::OpID::Or || id == User::OpID::Eq || id == User::OpID::Ne;
+    }
     struct InstHash
     {
         size_t operator()(User* inst) const
         {
-            size_t HashValue;
-            HashValue += std::hash<User::OpID>{}(inst->GetInstId());
+            size_t HashValue = std::hash<int>{}(inst->GetInstId());
+            // 可交换的指令要保证 a+b 和 b+a 的哈希值相同
+            if(IsCommutative(inst->GetInstId()))
+            {
+                size_t OperandHash = 0;
+                for(auto& Use_ : inst->Getuselist())
+                    OperandHash += std::hash<Value*>{}(Use_->usee);
+                return HashValue * 111 + OperandHash;
+            }
             for(auto& Use_ : inst->Getuselist())
             {
                 Value* val = Use_->usee;
@@ -30,7 +45,7 @@ namespace InstHashTool{
             auto& RHSUseList = RHS->Getuselist();
             if(LHSUseList.size() != RHSUseList.size())
                 return false;
-            if((LHS->GetInstId() > 7 && LHS->GetInstId() < 11) ||  (LHS->GetInstId() > 12 && LHS->GetInstId() < 17))
+            if(IsCommutative(LHS->GetInstId()))
                 return std::is_permutation(LHSUseList.begin(), LHSUseList.end(), RHSUseList.begin(), []
                     (std::unique_ptr<Use>& lhs, std::unique_ptr<Use>& rhs){ return lhs->usee == rhs->usee; });
             return std::equal(LHSUseList.begin(), LHSUseList.end(), RHSUseList.begin(), []
@@ -38,7 +53,15 @@ namespace InstHashTool{
         }
     };
 }
-template <typename Key, typename Val, typename AllocatorTy>
+/// @brief 直接走 operator new/delete 的分配器
+struct HashScopeAllocator
+{
+    template <typename T>
+    T* Allocate() { return static_cast<T*>(::operator new(sizeof(T))); }
+    template <typename T>
+    void Deallocate(T* ptr) { ::operator delete(ptr); }
+};
+template <typename Key, typename Val, typename AllocatorTy, typename HashTy, typename EqualTy>
 class HashScope;
 template <typename Key, typename Val>
 class HashScopeIterator;
@@ -73,17 +96,17 @@ template <typename AllocatorTy>
 template <typename AllocatorTy>
     void Delete(AllocatorTy &Allocator)
     {
-        this->~ScopedHashTableVal();
+        this->~HashScopeVal();
         Allocator.Deallocate(this);
     }
 
 };
 
-template <typename Key, typename Val, typename AllocatorTy>
+template <typename Key, typename Val, typename AllocatorTy, typename HashTy, typename EqualTy>
 class HashScope_Scope
 {
-friend class HashScope<Key, Val, AllocatorTy>;
-    HashScope<Key, Val, AllocatorTy>& HashTable;
+friend class HashScope<Key, Val, AllocatorTy, HashTy, EqualTy>;
+    HashScope<Key, Val, AllocatorTy, HashTy, EqualTy>& HashTable;
 
     HashScope_Scope* PrevScope;
     // 作用域最后插入的值，如果尚未插入，则为空。
@@ -93,7 +116,7 @@ friend class HashScope<Key, Val, AllocatorTy>;
     HashScope_Scope(HashScope_Scope&) = delete;
 
 public:
-    HashScope_Scope(HashScope<Key, Val, AllocatorTy>& HashTable) : HashTable(HashTable)
+    HashScope_Scope(HashScope<Key, Val, AllocatorTy, HashTy, EqualTy>& HashTable) : HashTable(HashTable)
     {
         PrevScope = HashTable.CurScope;
         HashTable.CurScope = this;
@@ -105,7 +128,7 @@ public:
         HashTable.CurScope = PrevScope;
         while(HashScopeVal<Key, Val>* thisval = LastVal)
         {
-            if(!thisval->GetNextForScope())
+            if(!thisval->GetNextForKey())
             {
                 assert(HashTable.Mapping[thisval->GetKey()] == thisval && "imbalance!");
                 HashTable.Mapping.erase(thisval->GetKey());
@@ -138,21 +161,25 @@ public:
     bool operator!=(const HashScopeIterator& RHS) const { return Ptr != RHS.Ptr; }
 };
 
-template <typename Key, typename Val, typename AllocatorTy>
+/// @brief 按作用域插入的哈希表, 作用域析构时撤销其中插入的所有值, 同一个 key 露出外层的值
+template <typename Key, typename Val, typename AllocatorTy = HashScopeAllocator,
+          typename HashTy = std::hash<Key>, typename EqualTy = std::equal_to<Key>>
 class HashScope
 {
-    typedef HashScope_Scope<Key, Val, AllocatorTy> Scope;
+public:
+    typedef HashScope_Scope<Key, Val, AllocatorTy, HashTy, EqualTy> Scope;
+private:
     typedef unsigned size_t;
     typedef HashScopeVal<Key, Val> Val_Ptr;
     // TODO: Restruct a unordered_map
-    std::unordered_map<Key, Val_Ptr*> Mapping;
+    std::unordered_map<Key, Val_Ptr*, HashTy, EqualTy> Mapping;
     Scope* CurScope;
 
     AllocatorTy Allocator;
 
     HashScope(const HashScope& );
     void operator=(const HashScope& );
-    friend class HashScope_Scope<Key, Val, AllocatorTy>;
+    friend class HashScope_Scope<Key, Val, AllocatorTy, HashTy, EqualTy>;
 public:
     HashScope() { CurScope = nullptr; }
     HashScope(AllocatorTy Allocator_) : CurScope(0), Allocator(Allocator_) {}
@@ -166,7 +193,7 @@ public:
     {
         assert(scope && "No scope!");
         HashScopeVal<Key, Val>*& entry = Mapping[key];
-        entry = Val_Ptr::Create(entry, scope->LastVal, key, val, Allocator);
+        entry = Val_Ptr::Create(scope->LastVal, entry, key, val, Allocator);
         scope->SetLastVal(entry);
     }
 